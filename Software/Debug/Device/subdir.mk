@@ -9,6 +9,7 @@ CPP_SRCS += \
 ../Device/HardwareGpio.cpp \
 ../Device/HardwareI2C1.cpp \
 ../Device/HardwarePWM.cpp \
+../Device/HardwarePeriodicTimer.cpp \
 ../Device/HardwareSPI.cpp \
 ../Device/HardwareTimer.cpp 
 
@@ -18,6 +19,7 @@ OBJS += \
 ./Device/HardwareGpio.o \
 ./Device/HardwareI2C1.o \
 ./Device/HardwarePWM.o \
+./Device/HardwarePeriodicTimer.o \
 ./Device/HardwareSPI.o \
 ./Device/HardwareTimer.o 
 
@@ -27,6 +29,7 @@ CPP_DEPS += \
 ./Device/HardwareGpio.d \
 ./Device/HardwareI2C1.d \
 ./Device/HardwarePWM.d \
+./Device/HardwarePeriodicTimer.d \
 ./Device/HardwareSPI.d \
 ./Device/HardwareTimer.d 
 
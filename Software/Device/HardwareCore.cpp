@@ -76,6 +76,12 @@ enableInterrupt(InterruptId const id) const
 	case EncoderTimer_Int:
 		NVIC_EnableIRQ(TIM3_IRQn);
 		break;
+	case Timer6Int:
+		NVIC_EnableIRQ(TIM6_DAC_IRQn);
+		break;
+	case Timer7Int:
+		NVIC_EnableIRQ(TIM7_IRQn);
+		break;
 	case EXTI_Int:
 		NVIC_EnableIRQ(EXTI0_IRQn);
 		NVIC_EnableIRQ(EXTI1_IRQn);
@@ -133,6 +139,12 @@ disableInterrupt(InterruptId const id) const
 	case EncoderTimer_Int:
 		NVIC_DisableIRQ(TIM3_IRQn);
 		break;
+	case Timer6Int:
+		NVIC_DisableIRQ(TIM6_DAC_IRQn);
+		break;
+	case Timer7Int:
+		NVIC_DisableIRQ(TIM7_IRQn);
+		break;
 	case EXTI_Int:
 		NVIC_DisableIRQ(EXTI0_IRQn);
 		NVIC_DisableIRQ(EXTI1_IRQn);
@@ -499,6 +511,22 @@ void TIM3_IRQHandler(void)
 }
 
 
+// Timer6 (Sweep Timer Channel 1)
+extern "C" __attribute__ ((interrupt ("IRQ")))
+void TIM6_DACUNDER_IRQHandler(void)
+{
+	Device::InterruptMgr::reference().handleInterrupt(Device::InterruptId::Timer6Int);
+}
+
+
+// Timer7 (Sweep Timer Channel 2)
+extern "C" __attribute__ ((interrupt ("IRQ")))
+void TIM7_IRQHandler(void)
+{
+	Device::InterruptMgr::reference().handleInterrupt(Device::InterruptId::Timer7Int);
+}
+
+
 // EXTI
 extern "C" __attribute__ ((interrupt ("IRQ")))
 void EXTI0_IRQHandler(void)
@@ -24,6 +24,8 @@ enum InterruptId : std::uint8_t {
 	DMA1_CH4Int,
 	DMA1_CH5Int,
 	EncoderTimer_Int, 		//Encoder
+	Timer6Int,
+	Timer7Int,
 	EXTI_Int,
 
 	IntCount
@@ -153,6 +155,16 @@ public:
 
 	static inline void enableInterrupts(void) { __enable_irq(); }
 
+	/* Start the cycle counter of the DWT unit (counts with the core clock) */
+	static inline void enableCycleCounter(void)
+	{
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	static inline std::uint32_t cycleCount(void) { return DWT->CYCCNT; }
+
 
 	static std::uint32_t systemCoreClock(void);
 
@@ -0,0 +1,88 @@
+
+#include <functional>
+#include <cstdint>
+#include "stm32l476xx.h"
+#include "HardwareCore.h"
+#include "HardwarePeriodicTimer.h"
+
+
+//---------------------------------------------------------------------------------------
+// --------------- Implementation of Class 'HardwarePeriodicTimer' ----------------------
+
+Device::HardwarePeriodicTimer::
+HardwarePeriodicTimer(TIM_TypeDef* base, InterruptId const interruptId, const std::uint32_t coreClock) :
+	base_(base),
+	interruptId_(interruptId),
+	prescaler_((coreClock / 1000000) - 1)
+{
+	using namespace Device;
+
+	// activate Clock for Timer
+	std::uint8_t bitPos = (reinterpret_cast<std::uint32_t>(base_) - APB1PERIPH_BASE)>>10;
+	RCC->APB1ENR1	|= 0x01<<bitPos;
+
+	// configure Timer registers: Only counter overflow generates an update interrupt
+	base_->CR1		|= 0x01<<2;
+
+	base_->DIER		&= ~(0x01<<0);
+	base_->CR1		&= ~(0x01<<0);
+
+	// configure Interrupt
+	InterruptMgr::reference().addHandlerForInterrupt(interruptId_, [this]() { this->interruptHandler(); });
+}
+
+
+Device::HardwarePeriodicTimer::
+~HardwarePeriodicTimer()
+{
+	// Disable interrupt
+	Device::InterruptMgr::reference().disableInterrupt(interruptId_);
+
+	// Disable clock
+	std::uint8_t bitPos = (reinterpret_cast<std::uint32_t>(base_) - APB1PERIPH_BASE)>>10;
+	RCC->APB1ENR1	&= ~(0x01<<bitPos);
+}
+
+
+void Device::HardwarePeriodicTimer::
+start(const std::uint32_t period) const
+{
+	// period is time in micro seconds!
+	stop();
+
+	// Count micro seconds, the update event is created after ARR + 1 counts
+	base_->CNT = 0;
+	base_->PSC = prescaler_;
+	base_->ARR = (period > maxPeriod) ? (maxPeriod - 1) : (period - 1);
+
+	// generate update event to use new ARR and PSC values, without calling the handler
+	base_->EGR |= 0x01<<0;
+	base_->SR	&= ~(0x01<<0);
+
+	// start timer
+	base_->DIER	|= 0x01<<0;
+	base_->CR1	|= 0x01<<0;
+}
+
+
+void Device::HardwarePeriodicTimer::
+stop(void) const
+{
+	// stop timer
+	base_->DIER	&= ~(0x01<<0);
+	base_->CR1	&= ~(0x01<<0);
+	base_->SR	&= ~(0x01<<0);
+}
+
+
+void Device::HardwarePeriodicTimer::
+interruptHandler(void) const
+{
+	// clear flag in status register
+	base_->SR	&= ~(0x01<<0);
+
+	// execute callback function, the timer keeps running
+	if (callbackHandler_) {
+		callbackHandler_();
+	}
+}
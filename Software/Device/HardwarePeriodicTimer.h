@@ -0,0 +1,63 @@
+#ifndef HARDWAREPERIODICTIMER_H_
+#define HARDWAREPERIODICTIMER_H_
+
+
+#include <functional>
+#include <cstdint>
+#include "stm32l476xx.h"
+#include "HardwareCore.h"
+
+
+namespace Device
+{
+
+/* Class HardwarePeriodicTimer
+ * 	Basic timer (TIM6 or TIM7) creating an update event every period. The period is counted in
+ * 	microseconds by the hardware, so late interrupts don't shift the following ones.
+ *
+ * 	The callback handler is executed directly in the interrupt service routine. It must be short
+ * 	and must not allocate memory.
+ */
+class HardwarePeriodicTimer
+{
+public:
+
+	typedef std::function<void (void)> TCallbackHandler;
+
+	/* Longest period in µs (16-bit counter) */
+	static const std::uint32_t maxPeriod = 65536;
+
+	/* Constructor */
+	HardwarePeriodicTimer(TIM_TypeDef* base, InterruptId const interruptId, const std::uint32_t coreClock);
+
+	~HardwarePeriodicTimer();
+
+	/* Start the timer with the given period in µs. The first callback follows after one period */
+	void start(const std::uint32_t period) const;
+
+	/* Stop timer */
+	void stop(void) const;
+
+	/* Set callback handler */
+	template <typename TFunc>
+	void setCallbackHandler(TFunc&& func) const
+	{
+		callbackHandler_ = std::forward<TFunc>(func);
+	}
+
+
+private:
+
+	TIM_TypeDef* const base_;
+	InterruptId const interruptId_;
+	std::uint32_t const prescaler_;
+	mutable TCallbackHandler callbackHandler_;
+
+	void interruptHandler(void) const;
+
+};
+
+
+} /* namespace Device */
+
+#endif /* HARDWAREPERIODICTIMER_H_ */
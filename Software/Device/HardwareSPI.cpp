@@ -8,11 +8,14 @@
 //---------------------------------------------------------------------------------------
 // -------------------- Implementation of Class 'HardwareSPI' --------------------------
 
+constexpr std::uint32_t Device::HardwareSPI::pclkFrequency;
+constexpr Device::HardwareSPI::BusProfile Device::HardwareSPI::defaultProfile;
+
 
 Device::HardwareSPI::
 HardwareSPI(SPI_TypeDef* base) :
 	spiBase_(base),
-	currentClkPhase_(ClockPhase::FirstEdge)
+	currentProfile_(defaultProfile)
 {
 	/* Local variables for respective pins */
 	uint8_t pinSCK_ = 0;
@@ -21,19 +24,6 @@ HardwareSPI(SPI_TypeDef* base) :
 
 	DMA_Request_TypeDef* dmaCSELR_;
 
-	/*SPI clk divider
-	 *
-	 * 	000: fPCLK/2
-	 *	001: fPCLK/4
-	 *	010: fPCLK/8
-	 *	011: fPCLK/16
-	 *	100: fPCLK/32
-	 *	101: fPCLK/64
-	 *  110: fPCLK/128
-	 *	111: fPCLK/256
-	 */
-	uint8_t SPI_fclk_div = 0;
-
 	if(spiBase_ == SPI1) {
 		/* SPI1:
 		 * 		GPIO	(PA4		SPI1_NSS)
@@ -64,8 +54,6 @@ HardwareSPI(SPI_TypeDef* base) :
 		dmaChRX_ = 2;
 		dmaChTX_ = 3;
 
-		SPI_fclk_div = 4;
-
 
 		/* Configure SPI1 Interrupts */
 		Device::InterruptMgr::reference().addHandlerForInterrupt(Device::InterruptId::SPI1_Int, [this]() { this->spiHandler(); });
@@ -107,8 +95,6 @@ HardwareSPI(SPI_TypeDef* base) :
 		dmaChRX_ = 4;
 		dmaChTX_ = 5;
 
-		SPI_fclk_div = 4;
-
 		/* Configure SPI2 Interrupts */
 		Device::InterruptMgr::reference().addHandlerForInterrupt(Device::InterruptId::SPI2_Int, [this]() { this->spiHandler(); });
 
@@ -202,7 +188,7 @@ HardwareSPI(SPI_TypeDef* base) :
 	 * Clk_idle = 1
 	 * First Clock transition is first data capture edge
 	 * Master Mode
-	 * BaudRate = f_PCLK/128 -> 80MHz/128 = 625kHz
+	 * BaudRate = f_PCLK/32 -> 80MHz/32 = 2.5MHz (defaultProfile, each slave may set its own)
 	 * Data MSB first
 	 * Software Slave management (SSI Bit = 0)
 	 *
@@ -213,7 +199,7 @@ HardwareSPI(SPI_TypeDef* base) :
 	 * Rx Buffer not Empty Interrupt Enable
 	 *
 	 */
-	spiBase_->CR1 		|= (SPI_fclk_div<<3 | 0x01<<2 | 0x01<<1);
+	spiBase_->CR1 		|= (defaultProfile.prescaler<<3 | 0x01<<2 | defaultProfile.polarity<<1 | defaultProfile.phase<<0);
 	spiBase_->CR2 		|= (0x01<<12 | DataSize<<8 | 0x01<<2 | 0x01<<1 | 0x01<<0);
 
 	/* Enable SPI */
@@ -252,7 +238,7 @@ beginTransmit(const DataType* dataSrc, const std::size_t numOfBytes) const
 	dmaBase_->IFCR	|= (0x01<<((dmaChTX_-1)*4));
 
 	/* Configure DMA Tx Channel*/
-	dmaTX_->CNDTR	 = numOfBytes;
+	dmaTX_->CNDTR	 = (currentProfile_.frameSize > 8) ? (numOfBytes / 2) : numOfBytes;
 	dmaTX_->CMAR	 = reinterpret_cast<std::uint32_t>(dataSrc);
 
 	/* Enable DMA Tx Channel*/
@@ -267,7 +253,7 @@ beginReceive(const DataType* dataDest, const std::size_t numOfBytes) const
 	dmaBase_->IFCR	|= (0x01<<((dmaChRX_-1)*4));
 
 	/* Configure DMA Rx Channel*/
-	dmaRX_->CNDTR	 = numOfBytes;
+	dmaRX_->CNDTR	 = (currentProfile_.frameSize > 8) ? (numOfBytes / 2) : numOfBytes;
 	dmaRX_->CMAR	 = reinterpret_cast<std::uint32_t>(dataDest);
 
 	/* Enable DMA Rx Channel*/
@@ -278,26 +264,44 @@ beginReceive(const DataType* dataDest, const std::size_t numOfBytes) const
 void Device::HardwareSPI::
 setClockPhase(ClockPhase const phase) const
 {
-	if (phase != currentClkPhase_) {
-		currentClkPhase_ = phase;
+	BusProfile profile = currentProfile_;
+	profile.phase = phase;
 
-		/* Wait until SPI peripheral busy bit is cleared */
-		while(spiBase_->SR & 0x01<<7) { }
-
-		/*Disable SPI*/
-		spiBase_->CR1		&= ~(0x01<<6);
+	setBusProfile(profile);
+}
 
-		/* Change clock phase */
-		if (phase == ClockPhase::FirstEdge) {
-			spiBase_->CR1	&= ~(0x01<<0);
-		}
-		else if (phase == ClockPhase::SecondEdge) {
-			spiBase_->CR1	|= 0x01<<0;
-		}
 
-		/* Enable SPI */
-		spiBase_->CR1		|= (0x01<<6);
+void Device::HardwareSPI::
+setBusProfile(BusProfile const& profile) const
+{
+	if (profile == currentProfile_) {
+		return;
 	}
+	currentProfile_ = profile;
+
+	/* Wait until SPI peripheral busy bit is cleared */
+	while(spiBase_->SR & 0x01<<7) { }
+
+	/*Disable SPI*/
+	spiBase_->CR1		&= ~(0x01<<6);
+
+	/* Baud rate, clock polarity and clock phase */
+	spiBase_->CR1		&= ~(0x07<<3 | 0x01<<1 | 0x01<<0);
+	spiBase_->CR1		|= (profile.prescaler<<3 | profile.polarity<<1 | profile.phase<<0);
+
+	/* Frame size. The RXNE event needs 8 bit for small frames and 16 bit for the others */
+	std::uint8_t const halfWords = (profile.frameSize > 8) ? 0x01 : 0x00;
+	spiBase_->CR2		&= ~(0x01<<12 | 0x0F<<8);
+	spiBase_->CR2		|= ((halfWords ? 0x00 : 0x01)<<12 | (profile.frameSize - 1)<<8);
+
+	/* Memory and peripheral size of the DMA (only changed while the channels are disabled) */
+	dmaRX_->CCR			&= ~(0x03<<10 | 0x03<<8);
+	dmaRX_->CCR			|= (halfWords<<10 | halfWords<<8);
+	dmaTX_->CCR			&= ~(0x03<<10 | 0x03<<8);
+	dmaTX_->CCR			|= (halfWords<<10 | halfWords<<8);
+
+	/* Enable SPI */
+	spiBase_->CR1		|= (0x01<<6);
 }
 
 
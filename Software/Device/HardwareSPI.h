@@ -23,6 +23,33 @@ public:
 	typedef std::function<void (MiscStuff::ErrorCode returnValue)> TOpCompleteHandler;
 
 	enum ClockPhase : std::uint8_t {FirstEdge, SecondEdge};
+	enum ClockPolarity : std::uint8_t {IdleLow, IdleHigh};
+
+	/* Baud rate as divider of f_PCLK (80MHz) */
+	enum BaudRatePrescaler : std::uint8_t {Div2, Div4, Div8, Div16, Div32, Div64, Div128, Div256};
+	static constexpr std::uint32_t pclkFrequency = 80000000;
+
+	/* SPI clock in Hz for a prescaler */
+	static constexpr std::uint32_t baudRate(BaudRatePrescaler const prescaler)
+	{
+		return pclkFrequency >> (prescaler + 1);
+	}
+
+	/* Settings of the bus for one slave */
+	struct BusProfile {
+		BaudRatePrescaler	prescaler;
+		ClockPolarity		polarity;
+		ClockPhase			phase;
+		std::uint8_t		frameSize;		/* Bits per frame (4 to 16). Frames above 8 bits are read as half words */
+
+		bool operator==(BusProfile const& other) const {
+			return (prescaler == other.prescaler) && (polarity == other.polarity) && (phase == other.phase)
+					&& (frameSize == other.frameSize);
+		}
+	};
+
+	/* Profile set by the constructor: 2.5MHz, idle high, capture on the first edge, 8 bit */
+	static constexpr BusProfile defaultProfile = {Div32, IdleHigh, FirstEdge, 8};
 
 	//Constructor
 	explicit HardwareSPI(SPI_TypeDef* base);
@@ -39,6 +66,9 @@ public:
 	/* Change the Clock phase */
 	void setClockPhase(ClockPhase const phase) const;
 
+	/* Change baud rate, clock polarity and phase and frame size. Nothing is done, if the profile is already set */
+	void setBusProfile(BusProfile const& profile) const;
+
 
 	// Set callback functions
 	template <typename TFunc>
@@ -66,7 +96,7 @@ private:
 	DMA_Channel_TypeDef* dmaTX_;
 	volatile uint8_t dmaChTX_;
 	volatile uint8_t dmaChRX_;
-	mutable volatile ClockPhase currentClkPhase_;
+	mutable BusProfile currentProfile_;
 
 	// Storage for callback functions
 	mutable TOpCompleteHandler readCompleteHandler_;
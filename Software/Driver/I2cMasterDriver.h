@@ -29,9 +29,10 @@ public:
 	// Destructor
 	~I2cMasterBusManager();
 
-	/* Methods to send / receive data via the I2C bus */
+	/* Methods to send / receive data via the I2C bus. The data of a write is freed after it is sent.
+	 * asyncWrite returns false, if the queue is full (the data is freed right away then) */
 	template <typename PreCallType, typename PostCallType>
-	void asyncWrite(const std::uint8_t slaveAddr, const std::uint8_t* source, const std::size_t numOfBytes,
+	bool asyncWrite(const std::uint8_t slaveAddr, const std::uint8_t* source, const std::size_t numOfBytes,
 			PreCallType&& preCall, PostCallType&& postCall) const;
 
 	template <typename PreCallType, typename PostCallType>
@@ -110,8 +111,9 @@ public:
 	void asyncWriteRegister(const std::uint8_t regAddr, const std::uint8_t data, PreCallType&& preCall,
 			PostCallType&& postCall) const;
 
+	/* Returns false, if the data couldn't be copied or queued */
 	template <typename PreCallType, typename PostCallType>
-	void asyncWrite(const std::uint8_t* source, const std::size_t numOfBytes, PreCallType&& preCall,
+	bool asyncWrite(const std::uint8_t* source, const std::size_t numOfBytes, PreCallType&& preCall,
 			PostCallType&& postCall) const;
 
 	/* Receive operations */
@@ -162,21 +164,21 @@ asyncWriteRegister(const std::uint8_t regAddr, const std::uint8_t data, PreCallT
 
 template <typename TBusManager>
 template <typename PreCallType, typename PostCallType>
-void Driver::I2cSlaveDriver<TBusManager>::
+bool Driver::I2cSlaveDriver<TBusManager>::
 asyncWrite(const std::uint8_t* source, const std::size_t numOfBytes, PreCallType&& preCall, PostCallType&& postCall) const
 {
 	/* Create a new buffer */
 	std::uint8_t* buffer = reinterpret_cast<std::uint8_t*>(malloc(numOfBytes));
 	if (buffer == NULL) {
 		/* Error allocating new memory */
-		return;
+		return false;
 	}
 
 	/* Copy data to be sent in the created buffer */
 	std::memcpy(buffer, source, numOfBytes);
 
 	/* Call method of busManager */
-	busManager_.asyncWrite(slaveAddress_, buffer, numOfBytes, preCall, postCall);
+	return busManager_.asyncWrite(slaveAddress_, buffer, numOfBytes, preCall, postCall);
 }
 
 
@@ -254,14 +256,19 @@ Driver::I2cMasterBusManager<TI2cDevice, TEventLoop, TQueueSize>::
 
 template <typename TI2cDevice, typename TEventLoop, std::size_t TQueueSize>
 template <typename PreCallType, typename PostCallType>
-void Driver::I2cMasterBusManager<TI2cDevice, TEventLoop, TQueueSize>::
+bool Driver::I2cMasterBusManager<TI2cDevice, TEventLoop, TQueueSize>::
 asyncWrite(const std::uint8_t slaveAddr, const std::uint8_t* source, const std::size_t numOfBytes, PreCallType&& preCall, PostCallType&& postCall) const
 {
 	/* Lock the EventLoop to prevent a race condition on the taskQueue */
 	el_.lock();
 
 	/* Add new Task to the Queue */
-	taskQueue_.push(std::move(I2cTask_t(Mode::Transmission, slaveAddr, source, numOfBytes, preCall, postCall)));
+	if (taskQueue_.push(std::move(I2cTask_t(Mode::Transmission, slaveAddr, source, numOfBytes, preCall, postCall))) == false) {
+		/* Queue full: The task is dropped, its data would never be freed otherwise */
+		el_.unlock();
+		free(const_cast<std::uint8_t*>(source));
+		return false;
+	}
 
 	/* Unlock the EventLoop */
 	el_.unlock();
@@ -272,6 +279,8 @@ asyncWrite(const std::uint8_t slaveAddr, const std::uint8_t* source, const std::
 
 		startNextTask();
 	}
+
+	return true;
 }
 
 
@@ -11,6 +11,7 @@
 
 #include "stm32l476xx.h"
 #include "CircularBuffer.h"
+#include "HardwareCore.h"
 #include "HardwareGpio.h"
 
 
@@ -23,10 +24,26 @@ class SpiMasterBusManager
 public:
 
 	typedef typename TSpiDevice::DataType				DataType;
-	typedef typename TSpiDevice::ClockPhase				ClockPhase;
+	typedef typename TSpiDevice::BusProfile				BusProfile;
 	typedef typename TEventLoop::Task::HandlerType 		CallbackHandler;
 
-	enum DataHandling : std::uint8_t {standard, dspCommand, dspData, ddsCommand, ddsData};
+	/* ddsBurst streams SRAM data with a single chip select (address auto increment of the DDS), one DMA run and one
+	 * interrupt per buffer. Register commands that need a chip select frame each are sent with asyncTransaction() */
+	enum DataHandling : std::uint8_t {standard, dspCommand, dspData, ddsCommand, ddsBurst};
+
+	/* Priority class of a slave. Each class has its own queue, a free bus always takes the next real-time task first.
+	 * Display data of bulk slaves is sent in chunks of bulkChunkSize, so real-time tasks get the bus in between */
+	enum Priority : std::uint8_t {RealTime, Bulk, NumOfPriorities};
+	static constexpr std::size_t bulkChunkSize = 512;
+
+	/* Copies of commands (standard, dspCommand, ddsCommand) are kept without the heap: Short ones inside of
+	 * the task, longer ones in a block of a fixed pool. Longer commands or a pool without a free block are dropped */
+	static constexpr std::size_t inlineDataSize = 16;
+	static constexpr std::size_t poolBlockSize = 32;
+	static constexpr std::size_t poolNumOfBlocks = 4;
+
+	/* Estimated time in ns each chip select frame adds to its bytes: Interrupt, chip select and restart of the DMA */
+	static constexpr std::uint32_t segmentOverhead = 2000;
 
 	// Constructor
 	SpiMasterBusManager(const TSpiDevice& spi, const TEventLoop& el);
@@ -35,20 +52,47 @@ public:
 	~SpiMasterBusManager();
 
 	//Methods
+	/* The bus profile of the slave is applied before its task is started. It has to stay valid until then.
+	 * Returns false, if the task was dropped (queue full, command too long or no free pool block) */
+	template <typename TFunc>
+	bool asyncWrite(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+			Priority const priority, const DataType* source, const std::size_t numOfBytes, const enum DataHandling,
+			const TGpioDevice& displayCDBase, typename TGpioDevice::Pin const displayCDPin, TFunc&& callback) const;
+
+	/* Transaction of several segments, each one sent in its own chip select frame. The segments follow each other
+	 * in source, segmentSizes holds their number of bytes. Both are sent in place and have to stay valid until the
+	 * callback, which is called once after the last segment. Returns false, if the queue is full */
 	template <typename TFunc>
-	void asyncWrite(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const DataType* source,
-			const std::size_t numOfBytes, const enum DataHandling, const TGpioDevice& displayCDBase,
-			typename TGpioDevice::Pin const displayCDPin, TFunc&& callback) const;
+	bool asyncTransaction(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+			Priority const priority, const DataType* source, const std::uint8_t* segmentSizes, const std::size_t numOfSegments,
+			const enum DataHandling, TFunc&& callback) const;
 
 	template <typename TFunc>
-	void asyncRead(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const std::uint8_t* dest,
-			const std::size_t numOfBytes, TFunc&& callback) const;
+	void asyncRead(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+			Priority const priority, const std::uint8_t* dest, const std::size_t numOfBytes, TFunc&& callback) const;
+
+	/* Queue the callback to the event loop like the one of a sent task, e.g. for a dropped task whose
+	 * callback has to run nevertheless. It never runs inside the caller */
+	template <typename TFunc>
+	void postCallback(TFunc&& callback) const;
+
+	/* Estimated time in ns to send numOfBytes in numOfSegments chip select frames with the given bus profile,
+	 * once the task has the bus */
+	static std::uint32_t transferTime(const BusProfile& profile, const std::size_t numOfBytes, const std::size_t numOfSegments);
+
+	/* Longest time in µs a task of the class waited from being queued until it got the bus, measured with
+	 * the cycle counter since startup. It includes the tasks queued before it and, for real-time tasks,
+	 * the bulk chunk on the bus */
+	std::uint32_t maxWaitTime(Priority const priority) const;
 
 
 private:
 
 	enum Mode : std::uint8_t {Transmission, Reception};
 
+	/* Where the data of a task is stored */
+	enum Storage : std::uint8_t {Referenced, Inline, PoolBlock};
+
 	/* Flag to indicate if there is an ongoing task */
 	volatile mutable bool busBusy_;
 
@@ -63,6 +107,18 @@ private:
 		const DataType* dataPtr_;
 		std::size_t numOfBytes_;
 		CallbackHandler callback_;
+		enum Storage storage_;
+		std::uint8_t poolBlock_;
+		std::array<DataType, inlineDataSize> inlineData_;	//copy of a short command
+		const std::uint8_t* segmentSizes_;					//sizes of the segments of a transaction
+		std::uint16_t segmentSize_;							//size of the segments, if segmentSizes_ is nullptr (bulk chunks)
+		std::size_t numOfSegments_;							//chip select frames of the task
+		std::size_t segment_;								//segment on the bus
+		const BusProfile* profile_;							//bus settings of the slave
+		std::uint32_t queuedCycle_;							//cycle counter when the task was queued
+
+		/* The inline data moves with the task into the queue, so its address is taken when the task is started */
+		const DataType* data(void) const { return (storage_ == Storage::Inline) ? inlineData_.data() : dataPtr_; }
 
 		SpiTask_t() :
 			mode_(Mode::Transmission),
@@ -73,7 +129,15 @@ private:
 			displayCDBase_(nullptr),
 			dataPtr_(nullptr),
 			numOfBytes_(0),
-			callback_(nullptr)
+			callback_(nullptr),
+			storage_(Storage::Referenced),
+			poolBlock_(0),
+			segmentSizes_(nullptr),
+			segmentSize_(0),
+			numOfSegments_(1),
+			segment_(0),
+			profile_(nullptr),
+			queuedCycle_(0)
 		{
 		}
 
@@ -89,7 +153,15 @@ private:
 			displayCDBase_(cdBase),
 			dataPtr_(data),
 			numOfBytes_(numOfBytes),
-			callback_(std::forward<TFunc>(callback))
+			callback_(std::forward<TFunc>(callback)),
+			storage_(Storage::Referenced),
+			poolBlock_(0),
+			segmentSizes_(nullptr),
+			segmentSize_(0),
+			numOfSegments_(1),
+			segment_(0),
+			profile_(nullptr),
+			queuedCycle_(Device::Core::cycleCount())
 		{
 		}
 
@@ -104,24 +176,78 @@ private:
 			displayCDBase_(csBase),
 			dataPtr_(data),
 			numOfBytes_(numOfBytes),
-			callback_(std::forward<TFunc>(callback))
+			callback_(std::forward<TFunc>(callback)),
+			storage_(Storage::Referenced),
+			poolBlock_(0),
+			segmentSizes_(nullptr),
+			segmentSize_(0),
+			numOfSegments_(1),
+			segment_(0),
+			profile_(nullptr),
+			queuedCycle_(Device::Core::cycleCount())
 		{
 		}
+
+		/* Bytes sent in the current chip select frame */
+		std::size_t frameSize(void) const
+		{
+			if (segmentSizes_ != nullptr) {
+				return segmentSizes_[segment_];
+			}
+			if (segmentSize_ == 0) {
+				return numOfBytes_;
+			}
+			/* The last chunk may be shorter */
+			std::size_t const remaining = numOfBytes_ - (segment_ * segmentSize_);
+			return (remaining < segmentSize_) ? remaining : segmentSize_;
+		}
 	};
-	mutable Util::CircularBuffer<SpiTask_t, TQueueSize> taskQueue_;
+	mutable std::array<Util::CircularBuffer<SpiTask_t, TQueueSize>, NumOfPriorities> taskQueues_;
+
+	/* Queue of the task on the bus */
+	mutable volatile Priority activeQueue_;
+
+	/* Longest wait of each class for the bus in cycles of the core clock */
+	mutable std::array<std::uint32_t, NumOfPriorities> maxWaitCycles_;
+
+	/* Claim the bus and start the next task, if it's free. Has to be called while locked, unlocks */
+	void startIfIdle(void) const;
+
+	/* Fixed blocks for commands longer than inlineDataSize, one bit per used block */
+	mutable std::array<std::array<DataType, poolBlockSize>, poolNumOfBlocks> pool_;
+	mutable volatile std::uint32_t poolUsed_;
 
 	const TSpiDevice& spi_;
 	const TEventLoop& el_;
 
-	/* Starts the hardware spi appropriately for the next task */
+	/* Starts the hardware spi appropriately for the next task, real-time tasks first */
 	void startNextTask(void) const;
 
 	/* Callback for the Hardware SPI Device */
 	void taskComplete(MiscStuff::ErrorCode returnValue) const;
 
+	/* Copy a command into the task (inline or into a pool block). Has to be called while locked */
+	bool storeCommand(SpiTask_t& task, const DataType* source) const;
+
 };
 
 
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+constexpr std::size_t SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::bulkChunkSize;
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+constexpr std::size_t SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::inlineDataSize;
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+constexpr std::size_t SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::poolBlockSize;
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+constexpr std::size_t SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::poolNumOfBlocks;
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+constexpr std::uint32_t SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::segmentOverhead;
+
+
 /* Class for a SpiDriver
  * 	Each Slave in the system gets his own driver object which is managed by the BusManager.
  * 	Each driver object has its own buffer structure for Transmission and Reception of individual data.
@@ -133,24 +259,45 @@ public:
 
 	typedef TDataSize							DataType;
 	typedef typename TBusManager::DataHandling	DataHandling;
+	typedef typename TBusManager::BusProfile	BusProfile;
+	typedef typename TBusManager::Priority		Priority;
 
 	//Constructors
-	SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin);
-	SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin,
-			const TGpioDevice& displayCDBase, typename TGpioDevice::Pin const displayCDPin);
+	SpiSlaveDriver(const TBusManager& busManager, const BusProfile& profile, Priority const priority,
+			const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin);
+	SpiSlaveDriver(const TBusManager& busManager, const BusProfile& profile, Priority const priority,
+			const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const TGpioDevice& displayCDBase,
+			typename TGpioDevice::Pin const displayCDPin);
+
+	/*Transmit operation, returns false if the task was dropped*/
+	template <typename TFunc>
+	bool asyncWrite(const DataType* source, const std::size_t numOfBytes, const DataHandling dataHandling, TFunc&& callback) const;
 
-	/*Transmit operation*/
+	/*Transaction of several chip select frames with a single callback, see SpiMasterBusManager::asyncTransaction()*/
 	template <typename TFunc>
-	void asyncWrite(const DataType* source, const std::size_t numOfBytes, const DataHandling dataHandling, TFunc&& callback) const;
+	bool asyncTransaction(const DataType* source, const std::uint8_t* segmentSizes, const std::size_t numOfSegments,
+			const DataHandling dataHandling, TFunc&& callback) const;
 
 	/*Receive operation*/
 	template <typename TFunc>
 	void asyncRead(const DataType* dest, const std::size_t numOfBytes, TFunc&& callback) const;
 
+	/*Callback through the event loop without a transfer, see SpiMasterBusManager::postCallback()*/
+	template <typename TFunc>
+	void postCallback(TFunc&& callback) const;
+
+	/*Estimated time in ns to send a transaction to this slave, see SpiMasterBusManager::transferTime()*/
+	std::uint32_t transferTime(const std::size_t numOfBytes, const std::size_t numOfSegments) const
+	{
+		return TBusManager::transferTime(profile_, numOfBytes, numOfSegments);
+	}
+
 
 private:
 
 	const TBusManager& busManager_;
+	BusProfile const profile_;			//baud rate, clock polarity and phase and frame size of this slave
+	Priority const priority_;			//queue of the tasks of this slave
 	const TGpioDevice& slaveCsBase_;
 	typename TGpioDevice::Pin const slaveCsPin_;
 	const TGpioDevice& displayCDBase_;
@@ -163,8 +310,11 @@ private:
 // -------------------------------- Implementation --------------------------------------
 template <typename TBusManager, typename TGpioDevice, typename TDataSize>
 Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
-SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin) :
+SpiSlaveDriver(const TBusManager& busManager, const BusProfile& profile, Priority const priority,
+		const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin) :
 	busManager_(busManager),
+	profile_(profile),
+	priority_(priority),
 	slaveCsBase_(slaveCsBase),
 	slaveCsPin_(slaveCsPin),
 	displayCDBase_(slaveCsBase),
@@ -179,9 +329,12 @@ SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, ty
 
 template <typename TBusManager, typename TGpioDevice, typename TDataSize>
 Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
-SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin,
-		const TGpioDevice& displayCDBase, typename TGpioDevice::Pin const displayCDPin) :
+SpiSlaveDriver(const TBusManager& busManager, const BusProfile& profile, Priority const priority,
+		const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const TGpioDevice& displayCDBase,
+		typename TGpioDevice::Pin const displayCDPin) :
 	busManager_(busManager),
+	profile_(profile),
+	priority_(priority),
 	slaveCsBase_(slaveCsBase),
 	slaveCsPin_(slaveCsPin),
 	displayCDBase_(displayCDBase),
@@ -203,36 +356,23 @@ SpiSlaveDriver(const TBusManager& busManager, const TGpioDevice& slaveCsBase, ty
 
 template <typename TBusManager, typename TGpioDevice, typename TDataSize>
 template <typename TFunc>
-void Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
+bool Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
 asyncWrite(const DataType* source, const std::size_t numOfBytes, const DataHandling dataHandling, TFunc&& callback) const
 {
-	DataType* buff = nullptr;
-	/* Create a new buffer */
-	switch(dataHandling)
-	{
-		case DataHandling::standard:
-		case DataHandling::dspCommand:
-		case DataHandling::ddsCommand:
-			buff = reinterpret_cast<DataType*>(malloc(numOfBytes));
-			if (buff == NULL) {
-				/* Error allocating new memory */
-				return;
-			}
-			/* Copy data to be sent in the created buffer */
-			std::memcpy(buff, source, numOfBytes);
-			break;
-
-		case DataHandling::dspData:
-		case DataHandling::ddsData:
-			buff = const_cast<DataType*>(source);
-			break;
+	/* Commands are copied by the bus manager, data has to stay valid until it is sent */
+	return busManager_.asyncWrite(slaveCsBase_, slaveCsPin_, profile_, priority_, source, numOfBytes, dataHandling, displayCDBase_, displayCDPin_,
+			callback);
+}
 
-		default:
-			buff = nullptr;
-			break;
-	}
 
-	busManager_.asyncWrite(slaveCsBase_, slaveCsPin_, buff, numOfBytes, dataHandling, displayCDBase_, displayCDPin_, callback);
+template <typename TBusManager, typename TGpioDevice, typename TDataSize>
+template <typename TFunc>
+bool Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
+asyncTransaction(const DataType* source, const std::uint8_t* segmentSizes, const std::size_t numOfSegments,
+		const DataHandling dataHandling, TFunc&& callback) const
+{
+	return busManager_.asyncTransaction(slaveCsBase_, slaveCsPin_, profile_, priority_, source, segmentSizes, numOfSegments, dataHandling,
+			std::forward<TFunc>(callback));
 }
 
 
@@ -244,12 +384,26 @@ asyncRead(const DataType* dest, const std::size_t numOfBytes, TFunc&& callback)
 }
 
 
+template <typename TBusManager, typename TGpioDevice, typename TDataSize>
+template <typename TFunc>
+void Driver::SpiSlaveDriver<TBusManager, TGpioDevice, TDataSize>::
+postCallback(TFunc&& callback) const
+{
+	busManager_.postCallback(std::forward<TFunc>(callback));
+}
+
+
 //---------------------------------------------------------------------------------------
 //--------------------- Implementation of Class 'SpiMasterManager' ----------------------
 template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
 Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
 SpiMasterBusManager(const TSpiDevice& spi, const TEventLoop& el) :
 	busBusy_(false),
+	taskQueues_(),
+	activeQueue_(Priority::RealTime),
+	maxWaitCycles_(),
+	pool_(),
+	poolUsed_(0),
 	spi_(spi),
 	el_(el)
 {
@@ -272,50 +426,142 @@ Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
 
 template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
 template <typename TFunc>
-void Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
-asyncWrite(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const DataType* source,
-		const std::size_t numOfBytes, const enum DataHandling dataHandling, const TGpioDevice& displayCdBase,
-		typename TGpioDevice::Pin const displayCdPin, TFunc&& callback) const
+bool Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+asyncWrite(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+		Priority const priority, const DataType* source, const std::size_t numOfBytes, const enum DataHandling dataHandling,
+		const TGpioDevice& displayCdBase, typename TGpioDevice::Pin const displayCdPin, TFunc&& callback) const
 {
-	/* Lock the EventLoop to prevent a race condition on the taskQueue */
+	SpiTask_t task(Mode::Transmission, dataHandling, slaveCsPin, displayCdPin, &slaveCsBase,
+			&displayCdBase, source, numOfBytes, callback);
+	task.profile_ = &profile;
+
+	if ((priority == Priority::Bulk) && (dataHandling == DataHandling::dspData) && (numOfBytes > bulkChunkSize)) {
+		/* The display takes its data in chunks, each one in its own chip select frame */
+		task.segmentSize_ = bulkChunkSize;
+		task.numOfSegments_ = (numOfBytes + bulkChunkSize - 1) / bulkChunkSize;
+	}
+
+	/* Lock the EventLoop to prevent a race condition on the taskQueue and the pool */
 	el_.lock();
 
+	bool const stored = ((dataHandling != DataHandling::standard) && (dataHandling != DataHandling::dspCommand)
+			&& (dataHandling != DataHandling::ddsCommand)) || storeCommand(task, source);
+
 	/* Add new Task to the Queue */
-	taskQueue_.push(std::move(SpiTask_t(Mode::Transmission, dataHandling, slaveCsPin, displayCdPin, &slaveCsBase,
-			&displayCdBase, source, numOfBytes, callback)));
+	if ((stored == false) || (taskQueues_[priority].push(std::move(task)) == false)) {
+		/* Command too long, no free block or queue full: The task is dropped */
+		if (task.storage_ == Storage::PoolBlock) {
+			poolUsed_ = poolUsed_ & ~(1UL<<task.poolBlock_);
+		}
+		el_.unlock();
+		return false;
+	}
 
-	/* Unlock the EventLoop */
-	el_.unlock();
+	/* Writes are also started from interrupts (e.g. sweep steps) */
+	startIfIdle();
 
-	/* When there is nothing ongoing on the bus, start transmission */
-	if (busBusy_ == false) {
-		busBusy_ = true;
+	return true;
+}
 
-		startNextTask();
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+template <typename TFunc>
+bool Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+asyncTransaction(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+		Priority const priority, const DataType* source, const std::uint8_t* segmentSizes, const std::size_t numOfSegments,
+		const enum DataHandling dataHandling, TFunc&& callback) const
+{
+	if ((numOfSegments == 0) || (dataHandling == DataHandling::standard) || (dataHandling == DataHandling::dspCommand)
+			|| (dataHandling == DataHandling::ddsCommand)) {
+		/* Transactions are sent in place, as a whole */
+		return false;
 	}
+
+	SpiTask_t task(Mode::Transmission, dataHandling, slaveCsPin, slaveCsPin, &slaveCsBase,
+			&slaveCsBase, source, 0, std::forward<TFunc>(callback));
+	task.segmentSizes_ = segmentSizes;
+	task.numOfSegments_ = numOfSegments;
+	task.profile_ = &profile;
+
+	/* Lock the EventLoop to prevent a race condition on the taskQueue */
+	el_.lock();
+
+	if (taskQueues_[priority].push(std::move(task)) == false) {
+		el_.unlock();
+		return false;
+	}
+
+	startIfIdle();
+
+	return true;
 }
 
 
 template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
 template <typename TFunc>
 void Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
-asyncRead(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const std::uint8_t* dest,
-		const std::size_t numOfBytes, TFunc&& callback) const
+asyncRead(const TGpioDevice& slaveCsBase, typename TGpioDevice::Pin const slaveCsPin, const BusProfile& profile,
+		Priority const priority, const std::uint8_t* dest, const std::size_t numOfBytes, TFunc&& callback) const
 {
+	SpiTask_t task(Mode::Reception, slaveCsPin, &slaveCsBase, dest, numOfBytes, std::forward<TFunc>(callback));
+	task.profile_ = &profile;
+
 	/* Lock the EventLoop to prevent a race condition on the taskQueue */
 	el_.lock();
 
 	/* Add new Task to the Queue */
-	taskQueue_.push(std::move(SpiTask_t(Mode::Reception, slaveCsPin, &slaveCsBase, dest,
-			numOfBytes, std::forward<TFunc>(callback))));
+	if (taskQueues_[priority].push(std::move(task)) == false) {
+		el_.unlock();
+		return;
+	}
+
+	startIfIdle();
+}
+
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+template <typename TFunc>
+void Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+postCallback(TFunc&& callback) const
+{
+	el_.addTaskToQueue(std::forward<TFunc>(callback));
+}
+
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+std::uint32_t Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+transferTime(const BusProfile& profile, const std::size_t numOfBytes, const std::size_t numOfSegments)
+{
+	/* Bits on the bus at the baud rate of the profile, rounded up */
+	std::uint64_t const numOfBits = static_cast<std::uint64_t>(numOfBytes) * 8 * sizeof(DataType);
+	std::uint32_t const baudRate = TSpiDevice::baudRate(profile.prescaler);
+	std::uint32_t const bitTime = static_cast<std::uint32_t>(((numOfBits * 1000000000) + baudRate - 1) / baudRate);
+
+	return bitTime + (static_cast<std::uint32_t>(numOfSegments) * segmentOverhead);
+}
+
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+std::uint32_t Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+maxWaitTime(Priority const priority) const
+{
+	return maxWaitCycles_[priority] / (Device::Core::systemCoreClock() / 1000000);
+}
+
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+void Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+startIfIdle(void) const
+{
+	/* Claim the bus while still locked */
+	bool const startTransmission = (busBusy_ == false);
+	busBusy_ = true;
 
 	/* Unlock the EventLoop */
 	el_.unlock();
 
 	/* When there is nothing ongoing on the bus, start transmission */
-	if (busBusy_ == false) {
-		busBusy_ = true;
-
+	if (startTransmission) {
 		startNextTask();
 	}
 }
@@ -328,47 +574,45 @@ startNextTask(void) const
 	/* Lock the EventLoop to prevent a race condition on the taskQueue */
 	el_.lock();
 
-	/* Get data of next task */
-	SpiTask_t const& nextTask = taskQueue_.peek();
+	/* Get data of next task, a bulk task only gets the bus if no real-time task is waiting */
+	activeQueue_ = taskQueues_[Priority::RealTime].isEmpty() ? Priority::Bulk : Priority::RealTime;
+	SpiTask_t const& nextTask = taskQueues_[activeQueue_].peek();
+
+	/* Wait from queueing to the first segment, a bulk task resumed after real-time tasks doesn't count again */
+	if (nextTask.segment_ == 0) {
+		std::uint32_t const waitCycles = Device::Core::cycleCount() - nextTask.queuedCycle_;
+		if (waitCycles > maxWaitCycles_[activeQueue_]) {
+			maxWaitCycles_[activeQueue_] = waitCycles;
+		}
+	}
 
 	/* Unlock the EventLoop */
 	el_.unlock();
 
+	/* Settings of the slave, the hardware is only reconfigured when they differ from the previous slave.
+	 * This happens before CS goes low, so the slave sees the new clock polarity already when it's selected */
+	spi_.setBusProfile(*nextTask.profile_);
+
 	/* Set CS of corresponding SPI Slave to Low */
 	nextTask.slaveCsBase_->setPinStatus(nextTask.slaveCsPin_, Device::HardwareGpio::PinStatus::Low);
 
 	switch(nextTask.dataHandling_)
 	{
-		case standard:
-			spi_.setClockPhase(ClockPhase::FirstEdge);
-			break;
 		case dspCommand:
-			spi_.setClockPhase(ClockPhase::FirstEdge);
 			if(not (nextTask.displayCDBase_ == nextTask.slaveCsBase_ && nextTask.displayCDPin_ == nextTask.slaveCsPin_))
 				nextTask.displayCDBase_->setPinStatus(nextTask.displayCDPin_, Device::HardwareGpio::PinStatus::Low);
 			break;
 		case dspData:
-			spi_.setClockPhase(ClockPhase::FirstEdge);
 			if(not (nextTask.displayCDBase_ == nextTask.slaveCsBase_ && nextTask.displayCDPin_ == nextTask.slaveCsPin_))
 				nextTask.displayCDBase_->setPinStatus(nextTask.displayCDPin_, Device::HardwareGpio::PinStatus::High);
 			break;
-		case ddsCommand:
-		case ddsData:
-			spi_.setClockPhase(ClockPhase::SecondEdge);
-			break;
 		default:
 			break;
 	}
 
 	/* Start DMA for hardware spi */
 	if (nextTask.mode_ == Mode::Transmission) {
-		if (nextTask.dataHandling_ == DataHandling::ddsData) {
-			/* In case of ddsData, we only send 4 bytes */
-			spi_.beginTransmit(nextTask.dataPtr_, 4);
-		}
-		else {
-			spi_.beginTransmit(nextTask.dataPtr_, nextTask.numOfBytes_);
-		}
+		spi_.beginTransmit(nextTask.data(), nextTask.frameSize());
 	}
 	else if (nextTask.mode_ == Mode::Reception) {
 		spi_.beginReceive(nextTask.dataPtr_, nextTask.numOfBytes_);
@@ -387,8 +631,9 @@ taskComplete(MiscStuff::ErrorCode returnValue) const
 		/* Lock the EventLoop to prevent a race condition on the taskQueue */
 		el_.lock();
 
-		/* Get just finished task and remove it from the queue */
-		auto finishedTask = taskQueue_.peek();
+		/* Get just finished task, it stays in the queue until it is completely sent (no copy of it is made) */
+		auto& queue = taskQueues_[activeQueue_];
+		SpiTask_t const& finishedTask = queue.peek();
 
 		/* Unlock the EventLoop */
 		el_.unlock();
@@ -396,53 +641,104 @@ taskComplete(MiscStuff::ErrorCode returnValue) const
 		/* Set CS of corresponding SPI Slave to High */
 		finishedTask.slaveCsBase_->setPinStatus(finishedTask.slaveCsPin_, Device::HardwareGpio::PinStatus::High);
 
-		/* If the task was a transmission, release the memory of the sent data */
+		/* Next segment of a transaction or a bulk chunk */
+		if ((finishedTask.segment_ + 1) < finishedTask.numOfSegments_) {
+			SpiTask_t& transaction = queue.mutablePeek();
+			transaction.dataPtr_ += transaction.frameSize();
+			transaction.segment_++;
+
+			if ((activeQueue_ == Priority::RealTime) || taskQueues_[Priority::RealTime].isEmpty()) {
+				/* Restart right away with the same slave and bus profile */
+				transaction.slaveCsBase_->setPinStatus(transaction.slaveCsPin_, Device::HardwareGpio::PinStatus::Low);
+				spi_.beginTransmit(transaction.dataPtr_, transaction.frameSize());
+				return;
+			}
+
+			/* Real-time tasks first, the bulk task continues with its next chunk afterwards */
+			startNextTask();
+			return;
+		}
+
+		/* If the task was a transmission, release the pool block of the sent data */
 		if (finishedTask.mode_ == Mode::Transmission) {
 			switch(finishedTask.dataHandling_)
 			{
 				case DataHandling::standard:
 				case DataHandling::dspCommand:
-					free(const_cast<DataType*>(finishedTask.dataPtr_));
-					break;
-				case DataHandling::dspData:
-					break;
 				case DataHandling::ddsCommand:
-					free(const_cast<DataType*>(finishedTask.dataPtr_));
+					if (finishedTask.storage_ == Storage::PoolBlock) {
+						el_.lock();
+						poolUsed_ = poolUsed_ & ~(1UL<<finishedTask.poolBlock_);
+						el_.unlock();
+					}
 					break;
-				case DataHandling::ddsData:
-					/* Reduce numOfBytes by 4. Because we only peek() in the beginning of the method without removing
-					 * it from the queue, the just finished Task we handle right now is write accessable with mutablePeek() */
-					taskQueue_.mutablePeek().numOfBytes_ -= 4;
-					taskQueue_.mutablePeek().dataPtr_ += 4;
+				case DataHandling::dspData:
+				case DataHandling::ddsBurst:
 					break;
 				default:
 					break;
 			}
 		}
 
-		if ((finishedTask.dataHandling_ != DataHandling::ddsData) || (finishedTask.numOfBytes_ < 8)) {
-			/* Add callback to the EventLoop queue, if callback is valid */
-			if (finishedTask.callback_) {
-				el_.addTaskToQueue(finishedTask.callback_);
-			}
-
-			/* Delete Task */
-			el_.lock();
-			taskQueue_.deleteNext();
-			el_.unlock();
+		/* Add callback to the EventLoop queue, if callback is valid */
+		if (finishedTask.callback_) {
+			el_.addTaskToQueue(finishedTask.callback_);
 		}
+
+		/* Delete Task */
+		el_.lock();
+		queue.deleteNext();
+		el_.unlock();
 	}
 
 	/* In case of an error, just try again
 	 * Task where the error occured is still in the queue, so just start the next task */
 
-	/* Check if there is data to send next */
-	if (taskQueue_.available()) {
+	/* Check if there is data to send next. The bus is released while locked, so a new task either
+	 * sees it busy and is started here or sees it free and starts itself */
+	el_.lock();
+	bool const tasksLeft = (not taskQueues_[Priority::RealTime].isEmpty()) || (not taskQueues_[Priority::Bulk].isEmpty());
+	if (not tasksLeft) {
+		busBusy_ = false;
+	}
+	el_.unlock();
+
+	if (tasksLeft) {
 		startNextTask();
 	}
-	else {
-		busBusy_ = false;
+}
+
+
+template <typename TSpiDevice, typename TGpioDevice, typename TEventLoop, std::size_t TQueueSize>
+bool Driver::SpiMasterBusManager<TSpiDevice, TGpioDevice, TEventLoop, TQueueSize>::
+storeCommand(SpiTask_t& task, const DataType* source) const
+{
+	std::size_t const size = task.numOfBytes_ * sizeof(DataType);
+
+	if (task.numOfBytes_ <= inlineDataSize) {
+		std::memcpy(task.inlineData_.data(), source, size);
+		task.storage_ = Storage::Inline;
+		task.dataPtr_ = nullptr;
+		return true;
+	}
+
+	if (task.numOfBytes_ > poolBlockSize) {
+		return false;
 	}
+
+	/* First free block */
+	for (std::uint8_t i = 0; i < poolNumOfBlocks; i++) {
+		if ((poolUsed_ & (1UL<<i)) == 0) {
+			poolUsed_ = poolUsed_ | (1UL<<i);
+			std::memcpy(pool_[i].data(), source, size);
+			task.storage_ = Storage::PoolBlock;
+			task.poolBlock_ = i;
+			task.dataPtr_ = pool_[i].data();
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
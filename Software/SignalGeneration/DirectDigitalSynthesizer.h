@@ -4,14 +4,41 @@
 
 #include <cstdint>
 #include <limits>
+#include <array>
+#include <functional>
+#include <cmath>
 
 #include "SignalGenerationCommon.h"
+#include "SampleKernels.h"
+#include "SramSlotAllocator.h"
 
 
 namespace SignalGeneration {
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
+/* How patterns in the SRAM are replaced while the output is running */
+enum class SramUpdateMode : std::uint8_t {
+	StopOutput,		/* Stop pattern generation, rewrite the SRAM and restart (default) */
+	DoubleBuffered	/* Write the new pattern beside the playing one and switch with a single register update.
+					 * Opt-in: It needs the AD9102 to keep reading the SRAM while the SPI port has write access
+					 * (MEM_ACCESS), which is not confirmed on hardware yet */
+};
+
+
+/* Class DirectDigitalSynthesizer
+ * 	Controls one AD9102. Sine signals come from the internal DDS. Sawtooth and triangle signals
+ * 	come from the internal sawtooth generator, if the input frequency is a multiple of their period
+ * 	and there is no phase shift. All other signals are stored as patterns in the SRAM of the device.
+ * 	Arbitrary waveforms are resampled from a list of points to the number of samples needed for
+ * 	the requested frequency.
+ *
+ * 	For chirps, the SRAM holds tuning words instead of samples. The pattern generator steps through
+ * 	them, so the DDS sweeps by itself with the resolution of its clock. The tuning words go through
+ * 	the same slots and upload pipeline as the sample patterns.
+ *
+ * 	@template TDeviceCore - Provides the cycle counter to measure the duration of output changes
+ */
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
 class DirectDigitalSynthesizer
 {
 public:
@@ -31,6 +58,108 @@ public:
 	/* Enable / Disable signal generation on output */
 	auto setSignalGenerationEnabled(bool const enabled) const -> void;
 
+	/* Play a sine chirp with tuning words from the SRAM, until the next call of setOutput().
+	 * Returns false, if the chirp can't be created with the given input frequency */
+	auto setChirp(ChirpSettings const& chirp, std::uint32_t inputFrequency) const -> bool;
+
+	/* Output numOfCycles periods after each falling edge of the trigger pin instead of a continuous signal,
+	 * zero selects continuous output. Takes effect with the next call of setOutput(). Entering or leaving burst mode
+	 * restarts the pattern generator, so the first burst starts right away */
+	auto setBurstCycles(std::uint16_t const numOfCycles) const -> void { burstCycles_ = numOfCycles; }
+
+	/* Clock cycles of the input frequency one burst lasts, if the DDS or the sawtooth generator creates it.
+	 * Bursts from the SRAM repeat their pattern instead and are only limited by maxBurstCycles (result zero) */
+	static auto burstPatternClocks(ChannelSettings const& settings, std::uint32_t const inputFrequency,
+			std::uint16_t const numOfCycles) -> std::uint64_t;
+
+	/* Start a burst with a pulse on the trigger pin. The pin is shared, so all synthesizers in burst mode start.
+	 * Nothing happens while the pin is held high for a change of the settings, its falling edge starts the burst then.
+	 * Pulses up to maxTriggerWait are timed by busy waiting. Returns false for longer ones (low input frequency):
+	 * The pin stays high then and releaseTrigger() has to end the pulse after triggerPulseTime() */
+	auto triggerBurst(std::uint32_t const inputFrequency) const -> bool;
+
+	/* End a pulse left high by triggerBurst() */
+	auto releaseTrigger(void) const -> void;
+
+	/* Duration of the trigger pulse in µs, rounded up */
+	static auto triggerPulseTime(std::uint32_t const inputFrequency) -> std::uint32_t;
+
+	/* Longest trigger pulse in µs created by busy waiting */
+	static constexpr std::uint32_t maxTriggerWait = 10;
+
+	/* Set the points used for Waveform::Arbitrary. Takes effect with the next call of setOutput().
+	 * Until then, the built-in sinc pulse of defaultArbitraryPoints is played */
+	auto setArbitraryWaveform(ArbitraryWaveform const& waveform) const -> void;
+
+	/* Select how new SRAM patterns are written while the output is enabled, StopOutput by default */
+	auto setSramUpdateMode(SramUpdateMode const mode) const -> void { sramUpdateMode_ = mode; }
+
+	/* Time in µs the output was stopped during the last change of the settings (zero if the change was seamless).
+	 * Measured by the cycle counter from queueing the stop until the restart command completed, not the gap measured at the output */
+	auto lastInterruptionTime(void) const -> std::uint32_t { return cyclesToMicroseconds(lastInterruptionCycles_); }
+
+	/* Time in µs from the last call of setOutput() until the new settings were active */
+	auto lastUpdateTime(void) const -> std::uint32_t { return cyclesToMicroseconds(lastUpdateCycles_); }
+
+	/* Register writes dropped by the SPI driver (queue full), including the commands of dropped frames. Their registers
+	 * are written again with the next change of the settings, until then the output may differ from them or stay stopped */
+	auto droppedCommands(void) const -> std::uint32_t { return droppedCommands_; }
+
+	/* Longest chirp in clock cycles of the input frequency: each SRAM word is held up to 15 cycles */
+	static constexpr std::uint32_t maxChirpHold = 15;
+	static constexpr std::uint32_t maxChirpClocks = maxChirpHold * SampleKernels::maxNumOfSamples;
+
+	/* Bursts: The pattern is repeated up to 256 times (DAC_PAT), the pattern period counts up to 15 * 0xFFFF clocks */
+	static constexpr std::uint32_t maxBurstCycles = 256;
+	static constexpr std::uint32_t maxPatternClocks = 15 * 0xFFFF;
+
+	/* Registers a precomputed frame can write, combined as flags */
+	enum FrameRegister : std::uint8_t {
+		FrameTuningWordHigh = 0x01,		/* DDS_TW32: Bits 23..8 of the tuning word */
+		FrameTuningWordLow = 0x02,		/* DDS_TW1: Bits 7..0 of the tuning word */
+		FramePhaseWord = 0x04			/* DDS_PW */
+	};
+
+	/* Size of precomputed frames in bytes: One SPI command per register and the RAMUPDATE activating them */
+	static constexpr std::size_t frameCommandSize = 4;
+	static constexpr std::size_t maxFrameSize = 4 * frameCommandSize;
+	static constexpr std::size_t tuningWordFrameSize = 3 * frameCommandSize;
+
+	/* True, if the signal is played from a pattern in the SRAM (not from the DDS or the sawtooth generator) */
+	static auto usesSramPattern(ChannelSettings const& settings, std::uint32_t const inputFrequency) -> bool
+	{
+		return (settings.form_ != Waveform::Sine) and (sawGeneratorStep(settings, inputFrequency) == 0);
+	}
+
+	/* Calculate the tuning word for the 24-bit frequency divider */
+	static auto calculateTuningWord(std::uint32_t const inputFrequency, std::uint32_t const targetFrequency) -> std::uint32_t;
+
+	/* Calculate the phase word for a phase in degree (-180 to 180) */
+	static auto calculatePhaseWord(std::int32_t const phase) -> std::uint16_t;
+
+	/* Create the SPI commands writing the registers selected by the FrameRegister flags into frame, followed by
+	 * the RAMUPDATE. Returns the size of the frame in bytes */
+	static auto createFrame(std::uint8_t const registers, std::uint32_t const tuningWord, std::uint16_t const phaseWord,
+			std::uint8_t* const frame) -> std::size_t;
+
+	/* Create the SPI commands writing the given tuning word into frame (tuningWordFrameSize bytes) */
+	static auto createTuningWordFrame(std::uint32_t const tuningWord, std::uint8_t* const frame) -> void;
+
+	/* Send a precomputed frame as one SPI transaction. Allocates no memory and queues no callback,
+	 * so it can be called from an interrupt. The frame has to stay valid until it is sent.
+	 * Returns false, if the SPI driver dropped the frame (queue full) */
+	auto writeFrame(std::uint8_t const* const frame, std::size_t const frameSize) const -> bool;
+	auto writeTuningWordFrame(std::uint8_t const* const frame) const -> bool { return writeFrame(frame, tuningWordFrameSize); }
+
+	/* Estimated time in µs from the start of a frame on the bus until its RAMUPDATE is sent */
+	auto frameTransferTime(std::size_t const frameSize) const -> std::uint32_t
+	{
+		return (spi_.transferTime(frameSize, frameSize / frameCommandSize) + 999) / 1000;
+	}
+
+	/* Tuning word or phase word were changed with writeFrame(), the next setOutput() writes them again */
+	auto invalidateFrameRegisters(void) const -> void;
+
 private:
 
 	enum Register : std::uint16_t {
@@ -72,32 +201,239 @@ private:
 	};
 
 	struct CustomWaveform {
-		std::uint8_t* 	buffer;
 		std::uint16_t 	numOfSamples;
 		std::uint16_t	startAddr;
 		std::uint16_t	stopAddr;
 	};
 
+	/* State of the pipelined SRAM upload: Chunks of the pattern are created while the previous one is sent */
+	struct SramUploadPipeline {
+		SampleKernels::Pattern		pattern;
+		std::uint16_t				slotAddr;		/* SRAM address of the first word */
+		std::uint16_t				numOfWords;		/* Words to write, twice the period for rotatable patterns */
+		std::uint16_t				nextWord;		/* Next word to be created */
+		std::uint8_t				chunksInFlight;	/* Chunks handed to the SPI driver, but not sent yet */
+		std::int8_t					previousSlot;	/* Slot played before, it keeps playing if the upload is aborted */
+		bool						keepRunning;
+		bool						active;
+		bool						aborted;		/* The SPI driver dropped a chunk or the write access */
+		std::function<void (void)>	finished;		/* Queues the commands following the upload */
+	};
+
+	/* Kind of SRAM write needed to apply new settings */
+	enum class SramUpload : std::uint8_t {
+		None,
+		Seamless,		/* Pattern goes into a free slot while the output keeps running */
+		StopOutput		/* Pattern overwrites the playing one, output has to be stopped */
+	};
+
+	struct RegisterValue {
+		std::uint16_t	address;
+		std::uint16_t	data;
+	};
+
+	/* Registers describing one kind of output */
+	static constexpr std::size_t maxConfigSize = 11;
+	typedef std::array<RegisterValue, maxConfigSize> Configuration;
+
+	/* Tuning words of a chirp in the SRAM */
+	struct ChirpPattern {
+		std::uint16_t	startWord;		/* Upper 12 bits of the tuning words, see TW_RAM_CONFIG */
+		std::uint16_t	stopWord;
+		std::uint16_t	numOfSteps;
+		std::uint16_t	hold;			/* Clock cycles per step */
+		std::uint32_t	ratio;			/* Q2.30 ratio between the steps, zero for linear chirps */
+		std::uint16_t	shift;			/* TW_MEM_SHIFT: The SRAM word is placed at bit 12 - shift of the tuning word */
+	};
+
+	/* Samples per chunk of the SRAM upload and number of chunk buffers (one is sent while the next is created) */
+	static constexpr std::uint16_t chunkSize = 256;
+	static constexpr std::size_t numOfChunks = 2;
+
+	/* Layout of a chunk buffer: The SRAM address (burst header) is placed directly in front of the
+	 * samples. The samples themselves start word aligned, so the kernels can write two at once */
+	static constexpr std::size_t burstHeaderOffset = 2;
+	static constexpr std::size_t samplesOffset = 4;
+	static constexpr std::size_t chunkBufferSize = samplesOffset + (2 * chunkSize);
+
+	/* Number of registers mirrored in the register shadow (all registers below the SRAM) */
+	static constexpr std::size_t numOfShadowRegisters = CFG_ERROR + 1;
+
+	/* Marks a register of the shadow as unknown */
+	static constexpr std::int32_t unknownRegisterValue = -1;
+
+	/* DDS_CONFIG: The tuning word comes from the SRAM (TW_MEM_EN) */
+	static constexpr std::uint16_t tuningWordFromSram = 0x01<<2;
+
+	/* PAT_TIMEBASE: Each SRAM word is held for one clock cycle, both time bases count single cycles */
+	static constexpr std::uint16_t defaultPatternTimebase = 0x0111;
+
+	/* Clock cycles of the input frequency the trigger pin is held high before the falling edge */
+	static constexpr std::uint32_t triggerPulseClocks = 4;
+
+	/* Points of Waveform::Arbitrary until setArbitraryWaveform() is called: A sinc pulse over four zero crossings
+	 * on each side, the peak stays below full scale for the overshoot of the cubic interpolation */
+	static constexpr std::size_t numOfDefaultArbitraryPoints = 64;
+	static constexpr std::array<std::int16_t, numOfDefaultArbitraryPoints> defaultArbitraryPoints = {{
+		0, -943, -1801, -2434, -2728, -2614, -2078, -1169,
+		0, 1271, 2455, 3361, 3820, 3715, 3001, 1720,
+		0, -1949, -3858, -5429, -6366, -6416, -5402, -3248,
+		0, 4176, 9003, 14116, 19099, 23526, 27009, 29235,
+		30000, 29235, 27009, 23526, 19099, 14116, 9003, 4176,
+		0, -3248, -5402, -6416, -6366, -5429, -3858, -1949,
+		0, 1720, 3001, 3715, 3820, 3361, 2455, 1271,
+		0, -1169, -2078, -2614, -2728, -2434, -1801, -943
+	}};
+
+	/* Register writes of one operation are sent as one SPI transaction: Each command keeps its own chip select
+	 * frame, but the SPI interrupt moves on to the next one directly and there is only one callback at the end */
+	static constexpr std::size_t maxTransactionCommands = 16;
+	static constexpr std::size_t numOfTransactions = 3;
+	static constexpr std::int8_t noTransaction = -1;
+
+	struct CommandTransaction {
+		std::array<std::uint8_t, maxTransactionCommands * frameCommandSize>	commands;
+		std::uint8_t				numOfCommands;
+		bool						busy;			/* Open or handed to the SPI driver */
+		std::function<void (void)>	finished;		/* Callback of the last command */
+	};
+
+	/* Collect the following register writes into a transaction. Does nothing, if one is open already.
+	 * Without a free transaction buffer the writes are sent one by one */
+	auto beginTransaction(void) const -> void;
+
+	/* Send the commands collected so far. Returns false, if a command was dropped */
+	auto endTransaction(void) const -> bool;
+
+	/* Hand the open transaction to the SPI driver, the callback follows its last command. If the queue is full,
+	 * all commands are dropped. The callback runs from the event loop in any case, so the operation isn't left
+	 * hanging. Returns false, if the transaction was dropped */
 	template <typename TFunc>
-	auto writeRegister(std::uint16_t const address, std::uint16_t const data, TFunc&& callback) const -> void;
+	auto submitTransaction(TFunc&& callback) const -> bool;
 
+	/* Called when a transaction is sent */
+	auto transactionSent(std::int8_t const index) const -> void;
+
+	/* A write with a callback ends an open transaction with the callback after this write. The callback runs
+	 * from the event loop even if the write is dropped, never inside this call. Returns false, if a command was dropped */
 	template <typename TFunc>
-	auto writeSramData(std::uint8_t* const data, std::size_t const numOfBytes, TFunc&& callback) const -> void;
+	auto writeRegister(std::uint16_t const address, std::uint16_t const data, TFunc&& callback) const -> bool;
+
+	/* A write without callback joins the open transaction, if there is one. Returns false, if a command was dropped */
+	auto writeRegister(std::uint16_t const address, std::uint16_t const data, std::nullptr_t) const -> bool;
+
+	/* Send a single command. Returns false, if it was dropped */
+	template <typename TFunc>
+	auto sendCommand(std::uint16_t const address, std::uint16_t const data, TFunc&& callback) const -> bool;
+
+	/* The register of a dropped command doesn't match the shadow anymore */
+	auto commandDropped(std::uint16_t const address) const -> void;
+
+	/* Returns false, if the SPI driver dropped the data */
+	template <typename TFunc>
+	auto writeSramData(std::uint8_t* const data, std::size_t const numOfBytes, TFunc&& callback) const -> bool;
+
+	/* Write the register only if the value differs from the register shadow.
+	 * Returns true, if a write was issued */
+	auto updateRegister(std::uint16_t const address, std::uint16_t const data) const -> bool;
+
+	/* Check if the register value differs from the register shadow */
+	auto registerDiffers(std::uint16_t const address, std::uint16_t const data) const -> bool;
+
+	/* Mark all registers of the shadow and the SRAM slots as unknown */
+	auto invalidateShadow(void) const -> void;
+
+	/* Select the SRAM slot for the given settings and prepare the pattern, if no slot holds it yet.
+	 * Returns how the pattern has to be written into the SRAM */
+	auto prepareSramPattern(ChannelSettings const& settings, std::uint32_t const inputFrequency) const -> SramUpload;
 
-	/* Set the tuning word for the 24-bit frequency divider */
-	auto setTuningWord(std::uint32_t const inputFrequency, std::uint32_t const targetFrequency) const -> void;
+	/* Find the slot holding the requested pattern or allocate one with numOfWords for it. playedWords is the end of
+	 * the window played from the slot, a slot shrunk below is uploaded again. The caller has to create the kernel
+	 * of the pattern, if it has to be uploaded */
+	auto selectSramSlot(SramResidency const& requested, std::uint16_t const numOfWords,
+			std::uint16_t const playedWords) const -> SramUpload;
 
-	auto createRamp(Waveform const type, std::uint32_t const inputFreq,
-			std::uint32_t const targetFreq, std::int32_t const phase) const -> void;
+	/* Tuning words for the chirp. Returns false, if the chirp can't be created */
+	static auto calculateChirpPattern(ChirpSettings const& chirp, std::uint32_t const inputFrequency, ChirpPattern& pattern) -> bool;
 
-	auto createTriangle(std::uint32_t const inputFreq, std::uint32_t const targetFreq,
-			std::int32_t const phase) const -> void;
+	/* Content hash of the points and the interpolation, see SramResidency */
+	static auto hashArbitraryWaveform(ArbitraryWaveform const& waveform) -> std::uint32_t;
 
-	auto createPwm(std::uint32_t const inputFreq, std::uint32_t const targetFreq,
-			std::int32_t const phase, std::uint32_t const dutyCycle) const -> void;
+	/* Append the registers selecting continuous output or a burst of burstCycles_ periods. patternClocks is the
+	 * length of a burst created by the DDS or the sawtooth generator, zero for bursts repeating an SRAM pattern */
+	auto appendBurstConfiguration(Configuration& config, std::size_t& configSize, std::uint64_t const patternClocks) const -> void;
+
+	/* Write the registers of the configuration that differ and upload the pattern, if needed. The output keeps
+	 * running during the change if possible, otherwise it is stopped and restarted afterwards */
+	auto applyConfiguration(Configuration const& config, std::size_t const configSize, SramUpload const sramUpload,
+			std::uint32_t const startCycle) const -> void;
+
+	/* Start the pipelined upload of the prepared pattern. The pattern generation keeps running, if requested.
+	 * finished is called after the last chunk, to queue the commands which have to follow the upload */
+	template <typename TFunc>
+	auto uploadSramPattern(bool const keepRunning, TFunc&& finished) const -> void;
+
+	/* Create the next chunk of the pattern in the given chunk buffer and hand it to the SPI driver */
+	auto queueChunk(std::size_t const chunkIndex) const -> void;
+
+	/* Called when a chunk is sent. Refills the chunk buffer or finishes the upload */
+	auto chunkSent(std::size_t const chunkIndex) const -> void;
+
+	/* Stop creating chunks and finish the upload as soon as the queued ones are sent. The slot is released,
+	 * the next request for the pattern uploads it again */
+	auto abortUpload(void) const -> void;
+
+	/* Disable the SRAM access and apply what was requested during the upload */
+	auto finishUpload(void) const -> void;
+
+	auto cyclesToMicroseconds(std::uint32_t const cycles) const -> std::uint32_t;
+
+	/* Check if a pattern with the given number of samples fits twice into the SRAM. Such patterns are stored
+	 * twice in a row, so a phase shift only moves the window of START_ADDR and STOP_ADDR. The slot allocator
+	 * drops the second copy of patterns not played when it runs out of room */
+	static auto isRotatable(std::uint16_t const numOfSamples) -> bool;
+
+	/* SAW_STEP of the internal sawtooth generator to create the given signal exactly.
+	 * Zero if the signal has to come from the SRAM */
+	static auto sawGeneratorStep(ChannelSettings const& settings, std::uint32_t const inputFrequency) -> std::uint8_t;
+
+	/* Offset of the window within a rotatable pattern to get the given phase */
+	static auto windowOffset(Waveform const form, std::int32_t const phase, std::uint16_t const numOfSamples) -> std::uint16_t;
+
+	/* Kernel for the given waveform and parameters */
+	auto createPattern(Waveform const form, std::uint16_t const numOfSamples, std::int32_t const phase,
+			std::uint32_t const dutyCycle) const -> SampleKernels::Pattern;
 
 	mutable bool outputEnabled_;
 	mutable CustomWaveform sramWave_;
+	mutable SramUploadPipeline sramUpload_;
+	mutable std::uint8_t* chunkBuffers_;
+	mutable SramSlotAllocator<> sramSlots_;
+	mutable std::int8_t activeSlot_;
+	mutable std::array<std::int32_t, numOfShadowRegisters> registerShadow_;
+	mutable ArbitraryWaveform arbitraryWaveform_;
+	mutable std::uint32_t arbitraryHash_;		/* Setting the same points again finds their slot */
+	mutable SramUpdateMode sramUpdateMode_;
+	mutable std::uint32_t lastInterruptionCycles_;
+	mutable std::uint32_t lastUpdateCycles_;
+	mutable std::uint32_t droppedCommands_;
+
+	/* Requests received during an upload, applied afterwards */
+	mutable ChannelSettings pendingSettings_;
+	mutable ChirpSettings pendingChirp_;
+	mutable std::uint32_t pendingInputFrequency_;
+	mutable bool settingsPending_;
+	mutable bool chirpPending_;
+
+	/* Periods per trigger, zero for continuous output */
+	mutable std::uint16_t burstCycles_;
+	mutable bool triggerPulsePending_;
+	mutable bool pendingEnabled_;
+	mutable bool enablePending_;
+
+	mutable std::array<CommandTransaction, numOfTransactions> transactions_;
+	mutable std::int8_t openTransaction_;
+	mutable std::array<std::uint8_t, maxTransactionCommands> commandSizes_;	/* Segment sizes of transactions and frames */
 
 	const TSpiSlaveDriver& spi_;
 	const TIoPin& triggerPin_;
@@ -105,346 +441,960 @@ private:
 
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::int32_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::unknownRegisterValue;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::size_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::frameCommandSize;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::size_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxFrameSize;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::size_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::tuningWordFrameSize;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::uint32_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxChirpClocks;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::uint32_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxBurstCycles;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::uint32_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxPatternClocks;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::uint32_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxTriggerWait;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::array<std::int16_t, DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::numOfDefaultArbitraryPoints>
+DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::defaultArbitraryPoints;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::size_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::maxTransactionCommands;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+constexpr std::size_t DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::numOfTransactions;
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
 DirectDigitalSynthesizer(const TSpiSlaveDriver& spi, const TIoPin& tiggerPin) :
 	outputEnabled_(false),
-	sramWave_({nullptr, 0, 0, 0}),
+	sramWave_({0, 0, 0}),
+	sramUpload_(),
+	chunkBuffers_(nullptr),
+	sramSlots_(),
+	activeSlot_(SramSlotAllocator<>::invalidSlot),
+	registerShadow_(),
+	arbitraryWaveform_({defaultArbitraryPoints.data(), numOfDefaultArbitraryPoints, Interpolation::Cubic}),
+	arbitraryHash_(hashArbitraryWaveform(arbitraryWaveform_)),
+	sramUpdateMode_(SramUpdateMode::StopOutput),
+	lastInterruptionCycles_(0),
+	lastUpdateCycles_(0),
+	droppedCommands_(0),
+	pendingSettings_(),
+	pendingChirp_(),
+	pendingInputFrequency_(0),
+	settingsPending_(false),
+	chirpPending_(false),
+	burstCycles_(0),
+	triggerPulsePending_(false),
+	pendingEnabled_(false),
+	enablePending_(false),
+	transactions_(),
+	openTransaction_(noTransaction),
+	commandSizes_(),
 	spi_(spi),
 	triggerPin_(tiggerPin)
 {
 	/* Set trigger pin to high to disable signal generation */
 	triggerPin_.setHigh();
 
-	/* Allocate memory for the samples buffer.
-	 * Each sample value occupies 4 bytes in memory (two address bytes and two data bytes) */
-	sramWave_.buffer = reinterpret_cast<std::uint8_t*>(malloc(4 * 4096));
+	/* Every command of a transaction is sent in its own chip select frame */
+	commandSizes_.fill(frameCommandSize);
+
+	/* Allocate memory for the chunks of the SRAM upload.
+	 * Each sample value occupies 2 bytes in memory, the SRAM address is only stored once per chunk */
+	chunkBuffers_ = reinterpret_cast<std::uint8_t*>(malloc(numOfChunks * chunkBufferSize));
+
+	/* Nothing is known about the content of the DDS yet */
+	invalidateShadow();
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
 ~DirectDigitalSynthesizer()
 {
-	/* Free memory of samples buffer */
-	if (sramWave_.buffer) {
-		free(sramWave_.buffer);
+	/* Free memory of chunk buffers */
+	if (chunkBuffers_) {
+		free(chunkBuffers_);
 	}
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
 template <typename TFunc>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-writeRegister(std::uint16_t address, std::uint16_t data, TFunc&& callback) const -> void
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+writeRegister(std::uint16_t address, std::uint16_t data, TFunc&& callback) const -> bool
 {
-	std::uint32_t toSend = __REV(address<<16 | data);
+	if (openTransaction_ != noTransaction) {
+		bool const collected = writeRegister(address, data, nullptr);
+		return submitTransaction(std::forward<TFunc>(callback)) and collected;
+	}
+
+	if (sendCommand(address, data, callback)) {
+		return true;
+	}
+
+	/* The operation goes on without this write, after the caller has returned */
+	spi_.postCallback(std::forward<TFunc>(callback));
+	return false;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+writeRegister(std::uint16_t address, std::uint16_t data, std::nullptr_t) const -> bool
+{
+	bool queued = true;
+
+	if (openTransaction_ != noTransaction) {
+		CommandTransaction& transaction = transactions_[openTransaction_];
+
+		if (transaction.numOfCommands == maxTransactionCommands) {
+			/* Full, continue in the next transaction */
+			queued = endTransaction();
+			beginTransaction();
+		}
+	}
 
-	spi_.asyncWrite(reinterpret_cast<std::uint8_t*>(&toSend), 4, TSpiSlaveDriver::DataHandling::ddsCommand, callback);
+	if (openTransaction_ == noTransaction) {
+		return sendCommand(address, data, nullptr) and queued;
+	}
+
+	/* Same byte order as a single command: Address, then data, MSB first */
+	CommandTransaction& transaction = transactions_[openTransaction_];
+	std::uint8_t* command = transaction.commands.data() + (transaction.numOfCommands * frameCommandSize);
+	command[0] = static_cast<std::uint8_t>(address>>8);
+	command[1] = static_cast<std::uint8_t>(address & 0xFF);
+	command[2] = static_cast<std::uint8_t>(data>>8);
+	command[3] = static_cast<std::uint8_t>(data & 0xFF);
+	transaction.numOfCommands++;
+
+	return queued;
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
 template <typename TFunc>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-writeSramData(std::uint8_t* data, std::size_t numOfBytes, TFunc&& callback) const -> void
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+sendCommand(std::uint16_t const address, std::uint16_t const data, TFunc&& callback) const -> bool
+{
+	std::uint32_t toSend = __REV(address<<16 | data);
+
+	bool const queued = spi_.asyncWrite(reinterpret_cast<std::uint8_t*>(&toSend), 4, TSpiSlaveDriver::DataHandling::ddsCommand,
+			std::forward<TFunc>(callback));
+	if (not queued) {
+		commandDropped(address);
+	}
+
+	return queued;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+commandDropped(std::uint16_t const address) const -> void
+{
+	droppedCommands_++;
+
+	if ((address == SPICONFIG) or (address == RAMUPDATE) or (address == PAT_STATUS) or (address >= numOfShadowRegisters)) {
+		/* Not shadowed: Which registers are active or running is open now, so the next change writes all of them.
+		 * PAT_TYPE differs then as well, which forces the stop and restart of the output */
+		registerShadow_.fill(unknownRegisterValue);
+		return;
+	}
+
+	registerShadow_[address] = unknownRegisterValue;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+beginTransaction(void) const -> void
 {
-	spi_.asyncWrite(data, numOfBytes, TSpiSlaveDriver::DataHandling::ddsData, callback);
+	if (openTransaction_ != noTransaction) {
+		return;
+	}
+
+	for (std::size_t i = 0; i < numOfTransactions; i++) {
+		if (not transactions_[i].busy) {
+			transactions_[i].busy = true;
+			transactions_[i].numOfCommands = 0;
+			openTransaction_ = static_cast<std::int8_t>(i);
+			return;
+		}
+	}
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-setTuningWord(std::uint32_t const inputFrequency, std::uint32_t const targetFrequency) const -> void
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+endTransaction(void) const -> bool
 {
-	/* Calculate divider to be sent to the DDS */
-	float dividerFactor = static_cast<float>(inputFrequency) / static_cast<float>(0xFFFFFF);
-	std::uint32_t frequencyDiv = (targetFrequency / dividerFactor) + 0.5;
+	if (openTransaction_ == noTransaction) {
+		return true;
+	}
 
-	/* Write new divider into the DDS registers */
-	writeRegister(DDS_TW32, (frequencyDiv & 0xFFFF00)>>8, nullptr);
-	writeRegister(DDS_TW1, (frequencyDiv & 0xFF)<<8, nullptr);
+	if (transactions_[openTransaction_].numOfCommands == 0) {
+		/* Nothing collected */
+		transactions_[openTransaction_].busy = false;
+		openTransaction_ = noTransaction;
+		return true;
+	}
 
+	return submitTransaction(nullptr);
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-createRamp(Waveform const type, std::uint32_t const inputFreq,
-		std::uint32_t const targetFreq, std::int32_t const phase) const -> void
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+template <typename TFunc>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+submitTransaction(TFunc&& callback) const -> bool
 {
-    /* Allocate used variables */
-    std::uint32_t* tempPtr = reinterpret_cast<std::uint32_t*>(sramWave_.buffer);
-	std::uint16_t address = SRAM_DATA;
-	float value = 0;
+	std::int8_t const index = openTransaction_;
+	CommandTransaction& transaction = transactions_[index];
+	openTransaction_ = noTransaction;
 
-	/* Calculate the number of samples */
-	std::uint16_t numOfSamples = static_cast<std::uint16_t>((static_cast<float>(inputFreq) / targetFreq) + 0.5);
+	transaction.finished = std::forward<TFunc>(callback);
 
-	/* Calculate the y delta between two samples */
-	float amplitudeDelta = (std::numeric_limits<std::int16_t>::max() - std::numeric_limits<std::int16_t>::min())
-			/ static_cast<float>(numOfSamples - 1);
+	bool const queued = spi_.asyncTransaction(transaction.commands.data(), commandSizes_.data(), transaction.numOfCommands,
+			TSpiSlaveDriver::DataHandling::ddsBurst, [this, index]() {
+		this->transactionSent(index);
+	});
 
-	/* Calculate the shift in the samples to represent the phase */
-	float numOfShiftSamples = (static_cast<float>(phase) / 360.0) * numOfSamples;
+	if (queued) {
+		return true;
+	}
 
-	/* Calculate first sample value */
-	if (type == Waveform::Saw_pos) {
-		value = std::numeric_limits<std::int16_t>::min() + (numOfShiftSamples * amplitudeDelta);
+	/* Queue full: Resending the commands one by one would only take more entries of the same full queue.
+	 * The registers of the dropped commands are marked in the shadow instead */
+	for (std::size_t i = 0; i < transaction.numOfCommands; i++) {
+		std::uint8_t const* command = transaction.commands.data() + (i * frameCommandSize);
+		commandDropped(static_cast<std::uint16_t>((command[0]<<8) | command[1]));
 	}
-	else if (type == Waveform::Saw_neg) {
-		value = std::numeric_limits<std::int16_t>::max() - (numOfShiftSamples * amplitudeDelta);
+
+	auto finished = std::move(transaction.finished);
+	transaction.finished = nullptr;
+	transaction.busy = false;
+
+	/* The callback carries the next step (restart, trigger, the upload), it must not get lost with the commands.
+	 * It runs from the event loop, like after a sent transaction, so the caller finishes its state first */
+	if (finished) {
+		spi_.postCallback(std::move(finished));
 	}
 
-    for (std::size_t i = 0; i < numOfSamples; i++) {
-    	/* Build the 4 byte reprensenting the address and the value of the sample */
-    	std::int16_t valueInt = 0;
-    	if (value >= 0) {
-    		valueInt = static_cast<std::int16_t>(value + 0.5);
-    	}
-    	else {
-    		valueInt = static_cast<std::int16_t>(value - 0.5);
-    	}
-    	std::uint32_t rawData = (address << 16) | static_cast<std::uint16_t>(valueInt);
+	return false;
+}
 
-    	/* Store current sample in the buffer.
-    	 * Reverse byte order to be compatible with the little endia architecture */
-		*tempPtr = __REV(rawData);
 
-		/* Increase address by 1 and tempPtr by 4 */
-		address++;
-		tempPtr++;
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+transactionSent(std::int8_t const index) const -> void
+{
+	/* Release the buffer first, the callback may start the next transaction */
+	auto finished = std::move(transactions_[index].finished);
+	transactions_[index].finished = nullptr;
+	transactions_[index].busy = false;
 
-		/* Calculate next sample */
-		if (type == Waveform::Saw_pos) {
-			value += amplitudeDelta;
-		}
-		else if (type == Waveform::Saw_neg) {
-			value -= amplitudeDelta;
-		}
-    }
+	if (finished) {
+		finished();
+	}
+}
 
-    /* Store custum wave parameters */
-    sramWave_.numOfSamples = numOfSamples;
-    sramWave_.startAddr = 0;
-    sramWave_.stopAddr = numOfSamples - 1;
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+template <typename TFunc>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+writeSramData(std::uint8_t* data, std::size_t numOfBytes, TFunc&& callback) const -> bool
+{
+	return spi_.asyncWrite(data, numOfBytes, TSpiSlaveDriver::DataHandling::ddsBurst, callback);
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-createTriangle(std::uint32_t const inputFreq, std::uint32_t const targetFreq,
-		std::int32_t const phase) const -> void
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+updateRegister(std::uint16_t const address, std::uint16_t const data) const -> bool
 {
-	/* Allocate used variables */
-	std::uint32_t* tempPtr = reinterpret_cast<std::uint32_t*>(sramWave_.buffer);
-	float value = 0;
-	bool signalRising = true; /* Direction of the signal: rising or falling */
-	std::uint16_t address = SRAM_DATA;
+	if (not registerDiffers(address, data)) {
+		return false;
+	}
 
-	/* Calculate the number of samples and the half of that */
-	std::uint16_t numOfSamples = static_cast<std::uint16_t>((static_cast<float>(inputFreq) / targetFreq) + 0.5);
-	std::uint16_t halfOfSamples = (numOfSamples + 1) / 2;
+	if (address < numOfShadowRegisters) {
+		registerShadow_[address] = data;
+	}
 
-	/* Calculate the y delta between two samples */
-	float amplitudeDelta = (std::numeric_limits<std::int16_t>::max() - std::numeric_limits<std::int16_t>::min())
-			/ static_cast<float>(halfOfSamples);
+	writeRegister(address, data, nullptr);
 
-	/* Calculate the the shift in the samples to represent the given phase */
-	std::uint16_t numOfShiftSamples;
-	if (phase >= 0) {
-		numOfShiftSamples = static_cast<std::uint16_t>(((static_cast<float>(phase) / 360.0) * numOfSamples) + 0.5);
+	return true;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+registerDiffers(std::uint16_t const address, std::uint16_t const data) const -> bool
+{
+	if (address >= numOfShadowRegisters) {
+		/* Not shadowed, always write */
+		return true;
 	}
-	else {
-		numOfShiftSamples = static_cast<std::uint16_t>((numOfSamples * (1 + (static_cast<float>(phase) / 360.0))) + 0.5);
+
+	return registerShadow_[address] != static_cast<std::int32_t>(data);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+invalidateShadow(void) const -> void
+{
+	registerShadow_.fill(unknownRegisterValue);
+	sramSlots_.invalidateAll();
+	activeSlot_ = SramSlotAllocator<>::invalidSlot;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+calculateTuningWord(std::uint32_t const inputFrequency, std::uint32_t const targetFrequency) -> std::uint32_t
+{
+	/* Output frequency = tuning word * input frequency / 2^24, rounded like the frequency planner does */
+	return static_cast<std::uint32_t>(((static_cast<std::uint64_t>(targetFrequency) << 24) + (inputFrequency / 2)) / inputFrequency);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+calculatePhaseWord(std::int32_t const phase) -> std::uint16_t
+{
+	static constexpr float phaseScaleFactor = std::numeric_limits<std::uint16_t>::max() / 360.0;
+	return static_cast<std::uint16_t>((phase + 180) * phaseScaleFactor);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+createFrame(std::uint8_t const registers, std::uint32_t const tuningWord, std::uint16_t const phaseWord,
+		std::uint8_t* const frame) -> std::size_t
+{
+	/* One command per register in the byte order of writeRegister(): Address, then data, MSB first */
+	std::size_t size = 0;
+	auto addCommand = [frame, &size](std::uint16_t const address, std::uint16_t const data) {
+		frame[size++] = static_cast<std::uint8_t>(address>>8);
+		frame[size++] = static_cast<std::uint8_t>(address & 0xFF);
+		frame[size++] = static_cast<std::uint8_t>(data>>8);
+		frame[size++] = static_cast<std::uint8_t>(data & 0xFF);
+	};
+
+	if (registers & FrameTuningWordHigh) {
+		addCommand(DDS_TW32, static_cast<std::uint16_t>((tuningWord & 0xFFFF00)>>8));
 	}
+	if (registers & FrameTuningWordLow) {
+		addCommand(DDS_TW1, static_cast<std::uint16_t>((tuningWord & 0xFF)<<8));
+	}
+	if (registers & FramePhaseWord) {
+		addCommand(DDS_PW, phaseWord);
+	}
+	addCommand(RAMUPDATE, 0x01);
 
-	/* Calculate the first sample and the direction of the signal based on the calculated shift */
-	if (numOfShiftSamples >= halfOfSamples) {
-		numOfShiftSamples -= halfOfSamples; // Update the shift due to the updated signal direction
-		value = std::numeric_limits<std::int16_t>::max() - (numOfShiftSamples * amplitudeDelta);
-		signalRising = false;
+	return size;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+createTuningWordFrame(std::uint32_t const tuningWord, std::uint8_t* const frame) -> void
+{
+	createFrame(FrameTuningWordHigh | FrameTuningWordLow, tuningWord, 0, frame);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+writeFrame(std::uint8_t const* const frame, std::size_t const frameSize) const -> bool
+{
+	std::size_t const numOfCommands = frameSize / frameCommandSize;
+
+	/* Sent in place, nothing is copied. Each command keeps its own chip select frame, but the frame takes a single
+	 * task of the queue and the SPI interrupt moves on to the next command directly */
+	if (not spi_.asyncTransaction(frame, commandSizes_.data(), numOfCommands, TSpiSlaveDriver::DataHandling::ddsBurst,
+			nullptr)) {
+		droppedCommands_ += numOfCommands;
+		return false;
 	}
-	else {
-		value = std::numeric_limits<std::int16_t>::min() + (numOfShiftSamples * amplitudeDelta);
+
+	return true;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+invalidateFrameRegisters(void) const -> void
+{
+	registerShadow_[DDS_TW32] = unknownRegisterValue;
+	registerShadow_[DDS_TW1] = unknownRegisterValue;
+	registerShadow_[DDS_PW] = unknownRegisterValue;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+cyclesToMicroseconds(std::uint32_t const cycles) const -> std::uint32_t
+{
+	return cycles / (TDeviceCore::systemCoreClock() / 1000000);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+isRotatable(std::uint16_t const numOfSamples) -> bool
+{
+	return (2 * numOfSamples) <= SramSlotAllocator<>::sramSize;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+sawGeneratorStep(ChannelSettings const& settings, std::uint32_t const inputFrequency) -> std::uint8_t
+{
+	std::uint64_t const sawPeriod = static_cast<std::uint64_t>(settings.frequency_) * sawCyclesPerStep(settings);
+	if (sawPeriod == 0) {
+		return 0;
+	}
+
+	/* Only exact multiples, otherwise the SRAM pattern is closer to the requested frequency */
+	std::uint64_t const step = inputFrequency / sawPeriod;
+	if ((step == 0) || (step > sawMaxStep) || (step * sawPeriod != inputFrequency)) {
+		return 0;
 	}
 
-	/* Calculate the remaining samples */
-	std::uint16_t remainingSamples = halfOfSamples - numOfShiftSamples;
+	return static_cast<std::uint8_t>(step);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+windowOffset(Waveform const form, std::int32_t const phase, std::uint16_t const numOfSamples) -> std::uint16_t
+{
+	std::uint16_t shift = SampleKernels::shiftSamples(phase, numOfSamples) % numOfSamples;
+
+	/* The rectangle is delayed by the phase, all other waveforms are advanced (like the kernels do it) */
+	if (form == Waveform::Rect) {
+		return (numOfSamples - shift) % numOfSamples;
+	}
+
+	return shift;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+prepareSramPattern(ChannelSettings const& settings, std::uint32_t const inputFrequency) const -> SramUpload
+{
+	std::uint16_t const numOfSamples = SampleKernels::numOfSamples(inputFrequency, settings.frequency_);
+	bool const rotatable = isRotatable(numOfSamples);
+
+	/* The phase of rotatable patterns is set with the window, so they are stored without phase shift */
+	std::int32_t patternPhase = rotatable ? 0 : settings.phase_;
+	std::uint32_t dutyCycle = 0;
 
-	for (std::size_t i = 0; i < numOfSamples; i++) {
-		/* Build the 4 byte reprensenting the address and the value of the sample */
-		std::int16_t valueInt = 0;
-		if (value >= 0) {
-			valueInt = static_cast<std::int16_t>(value + 0.5);
+	if (settings.form_ == Waveform::Rect) {
+		dutyCycle = settings.dutyCycle_;
+
+		/* Rectangles without edges are constant, phase and exact duty cycle don't matter then */
+		std::uint32_t numOfHighSamples = ((2 * numOfSamples * dutyCycle) + 100) / 200;
+		if (numOfHighSamples == 0) {
+			dutyCycle = 0;
+			patternPhase = 0;
 		}
-		else {
-			valueInt = static_cast<std::int16_t>(value - 0.5);
+		else if (numOfHighSamples >= numOfSamples) {
+			dutyCycle = 100;
+			patternPhase = 0;
 		}
-		std::uint32_t rawData = (address << 16) | static_cast<std::uint16_t>(valueInt);
+	}
 
-		/* Store current sample in the buffer.
-		 * Reverse byte order to be compatible with the little endia architecture */
-		*tempPtr = __REV(rawData);
+	std::uint32_t const contentHash = (settings.form_ == Waveform::Arbitrary) ? arbitraryHash_ : 0;
 
-		/* Increase address by 1 and tempPtr by 4 */
-		address++;
-		tempPtr++;
+	SramResidency requested = {settings.form_, numOfSamples, patternPhase, dutyCycle, contentHash, true};
 
-		/* Calculate next sample */
-		if (remainingSamples > 0) {
-			if (signalRising) {
-				value += amplitudeDelta;
-			}
-			else {
-				value -= amplitudeDelta;
-			}
-			remainingSamples -= 1;
-			if (remainingSamples == 0) {
-				signalRising = not signalRising;
-			}
-		}
-		else if (halfOfSamples > 0) {
-			if (signalRising) {
-				value += amplitudeDelta;
-			}
-			else {
-				value -= amplitudeDelta;
-			}
-			halfOfSamples -= 1;
-			if (halfOfSamples == 0) {
-				signalRising = not signalRising;
-			}
+	std::uint16_t const offset = rotatable ? windowOffset(settings.form_, settings.phase_, numOfSamples) : 0;
+
+	SramUpload const sramUpload = selectSramSlot(requested, rotatable ? (2 * numOfSamples) : numOfSamples,
+			numOfSamples + offset);
+	if (sramUpload != SramUpload::None) {
+		/* The samples are created chunk by chunk during the upload */
+		sramUpload_.pattern = createPattern(settings.form_, numOfSamples, patternPhase, dutyCycle);
+	}
+
+	/* Play the pattern of the selected slot */
+	auto const& slot = sramSlots_.slot(activeSlot_);
+
+	sramWave_.numOfSamples = numOfSamples;
+	sramWave_.startAddr = slot.startAddr + offset;
+	sramWave_.stopAddr = sramWave_.startAddr + numOfSamples - 1;
+
+	return sramUpload;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+selectSramSlot(SramResidency const& requested, std::uint16_t const numOfWords,
+		std::uint16_t const playedWords) const -> SramUpload
+{
+	SramUpload sramUpload = SramUpload::None;
+
+	/* Check if one of the slots already holds exactly this pattern */
+	std::int8_t slotIndex = sramSlots_.find(requested);
+
+	/* The second copy was dropped, but the window needs it */
+	if ((slotIndex != SramSlotAllocator<>::invalidSlot) && (sramSlots_.slot(slotIndex).length < playedWords)) {
+		sramSlots_.release(slotIndex);
+		slotIndex = SramSlotAllocator<>::invalidSlot;
+	}
+
+	if (slotIndex == SramSlotAllocator<>::invalidSlot) {
+		/* New pattern: Get a slot for it. In double buffered mode, the pattern currently
+		 * played (samples or tuning words) must survive until the switch. */
+		bool const sramPlaying = outputEnabled_ and ((registerShadow_[WAV_CONFIG] == 0x00)
+				or (registerShadow_[DDS_CONFIG] == tuningWordFromSram));
+
+		if (sramUpdateMode_ == SramUpdateMode::DoubleBuffered) {
+			slotIndex = sramSlots_.allocate(numOfWords, sramPlaying ? activeSlot_ : SramSlotAllocator<>::invalidSlot);
+			sramUpload = SramUpload::Seamless;
 		}
-		else {
-			if (signalRising) {
-				value += amplitudeDelta;
-			}
-			else {
-				value -= amplitudeDelta;
-			}
+
+		if (slotIndex == SramSlotAllocator<>::invalidSlot) {
+			/* No room beside the playing pattern, so it has to be overwritten */
+			slotIndex = sramSlots_.allocate(numOfWords);
+			sramUpload = SramUpload::StopOutput;
 		}
+
+		sramSlots_.setPattern(slotIndex, requested);
+
+		sramUpload_.previousSlot = activeSlot_;
+		sramUpload_.slotAddr = sramSlots_.slot(slotIndex).startAddr;
+		sramUpload_.numOfWords = numOfWords;
 	}
 
-	/* Store custum wave parameters */
-	sramWave_.numOfSamples = numOfSamples;
-	sramWave_.startAddr = 0;
-	sramWave_.stopAddr = numOfSamples - 1;
+	sramSlots_.touch(slotIndex);
+	activeSlot_ = slotIndex;
+
+	return sramUpload;
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
-createPwm(std::uint32_t const inputFreq, std::uint32_t const targetFreq,
-		std::int32_t const phase, std::uint32_t const dutyCycle) const -> void
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+calculateChirpPattern(ChirpSettings const& chirp, std::uint32_t const inputFrequency, ChirpPattern& pattern) -> bool
 {
-	/* Allocate used variables */
-	std::uint32_t* tempPtr = reinterpret_cast<std::uint32_t*>(sramWave_.buffer);
-	std::uint16_t address = SRAM_DATA;
-	std::int16_t value;
+	/* Clock cycles of the chirp, spread over as many SRAM words as possible */
+	std::uint64_t const clocks = (static_cast<std::uint64_t>(chirp.duration) * inputFrequency) / 1000000;
+	if ((clocks < 2) || (clocks > maxChirpClocks)) {
+		return false;
+	}
 
-	/* Calculate the number of samples */
-	std::uint16_t numOfSamples = static_cast<std::uint16_t>((static_cast<float>(inputFreq) / targetFreq) + 0.5);
+	pattern.hold = static_cast<std::uint16_t>((clocks + SampleKernels::maxNumOfSamples - 1) / SampleKernels::maxNumOfSamples);
+	pattern.numOfSteps = static_cast<std::uint16_t>(clocks / pattern.hold);
 
-	/* Calculate the shift in the samples to represent the phase */
-	std::uint16_t numOfShiftSamples = 0;
-	if (phase >= 0) {
-		numOfShiftSamples = static_cast<std::uint16_t>(((static_cast<float>(phase) / 360.0) * numOfSamples) + 0.5);
+	/* Both tuning words below the Nyquist frequency */
+	std::uint32_t const startWord = calculateTuningWord(inputFrequency, chirp.startFrequency);
+	std::uint32_t const stopWord = calculateTuningWord(inputFrequency, chirp.stopFrequency);
+	if ((startWord == 0) || (stopWord == 0) || (startWord >= (1UL<<23)) || (stopWord >= (1UL<<23))) {
+		return false;
 	}
-	else {
-		numOfShiftSamples = static_cast<std::uint16_t>((numOfSamples * (1 + (static_cast<float>(phase) / 360.0))) + 0.5);
+
+	/* The SRAM provides 12 bits of the tuning word, placed as low as the highest tuning word allows.
+	 * The bits above them come from DDS_TW32, which is set to zero */
+	std::uint32_t const maxWord = (startWord > stopWord) ? startWord : stopWord;
+	std::uint16_t position = 0;
+	while ((maxWord>>position) > 0x0FFF) {
+		position++;
 	}
+	pattern.shift = 12 - position;
 
-	/* Calculate the number of high samples */
-	std::uint16_t numOfHighSamples = static_cast<std::uint16_t>(((static_cast<float>(numOfSamples) * dutyCycle) / 100.0) + 0.5);
+	pattern.startWord = static_cast<std::uint16_t>(((startWord>>position) + ((position > 0) ? ((startWord>>(position - 1)) & 0x01) : 0)));
+	pattern.stopWord = static_cast<std::uint16_t>(((stopWord>>position) + ((position > 0) ? ((stopWord>>(position - 1)) & 0x01) : 0)));
+	if (pattern.startWord > 0x0FFF) {
+		pattern.startWord = 0x0FFF;
+	}
+	if (pattern.stopWord > 0x0FFF) {
+		pattern.stopWord = 0x0FFF;
+	}
 
-	/* Calculate the number of high samples before the phase shift starts */
-	std::int16_t numOfHighsBeforeShift = (numOfHighSamples + numOfShiftSamples) - numOfSamples;
+	pattern.ratio = 0;
+	if ((chirp.law == SweepLaw::Logarithmic) && (pattern.numOfSteps > 1) && (pattern.startWord != 0)) {
+		double const ratio = std::pow(static_cast<double>(pattern.stopWord) / pattern.startWord, 1.0 / (pattern.numOfSteps - 1));
+		pattern.ratio = static_cast<std::uint32_t>((ratio * (1UL<<30)) + 0.5);
+	}
 
-	for (std::size_t i = 0; i < numOfSamples; i++) {
-		/* Check if we still have to shift to get the phase right */
-		if (numOfShiftSamples > 0) {
-			if (numOfHighsBeforeShift > 0) {
-				value = std::numeric_limits<std::int16_t>::max();
-				numOfHighsBeforeShift -= 1;
-			}
-			else {
-				value = std::numeric_limits<std::int16_t>::min();
-			}
-			numOfShiftSamples -= 1;
-		}
-		else if (numOfHighSamples > 0) {
-			value = std::numeric_limits<std::int16_t>::max();
-			numOfHighSamples -= 1;
-		}
-		else {
-			value = std::numeric_limits<std::int16_t>::min();
-		}
+	return true;
+}
 
-		/* Build the 4 byte reprensenting the address and the value of the sample */
-		std::uint32_t rawData = (address << 16) | static_cast<std::uint16_t>(value);
 
-		/* Store current sample in the buffer.
-		 * Reverse byte order to be compatible with the little endian architecture */
-		*tempPtr = __REV(rawData);
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+createPattern(Waveform const form, std::uint16_t const numOfSamples, std::int32_t const phase,
+		std::uint32_t const dutyCycle) const -> SampleKernels::Pattern
+{
+	if (form == Waveform::Arbitrary) {
+		SampleKernels::Resampler resampler(arbitraryWaveform_.points, arbitraryWaveform_.numOfPoints,
+				(arbitraryWaveform_.interpolation == Interpolation::Cubic), numOfSamples, phase);
 
-		/* Increase address by 1 and tempPtr by 4 */
-		address++;
-		tempPtr++;
+		return SampleKernels::Pattern(resampler, numOfSamples);
+	}
+	else if (form == Waveform::Triangle) {
+		return SampleKernels::Pattern(SampleKernels::Triangle(numOfSamples, phase), numOfSamples);
+	}
+	else if (form == Waveform::Rect) {
+		return SampleKernels::Pattern(SampleKernels::Pwm(numOfSamples, phase, dutyCycle), numOfSamples);
 	}
 
-	/* Store custum wave parameters */
-	sramWave_.numOfSamples = numOfSamples;
-	sramWave_.startAddr = 0;
-	sramWave_.stopAddr = numOfSamples - 1;
+	return SampleKernels::Pattern(SampleKernels::Ramp((form == Waveform::Saw_neg), numOfSamples, phase), numOfSamples);
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
 initialize(void) const -> void
 {
+	beginTransaction();
+
 	/* Software reset of all registers */
 	writeRegister(SPICONFIG, 0x2004, nullptr);
+	invalidateShadow();
 
 	/* Set default SPI settings */
 	writeRegister(SPICONFIG, 0x00, nullptr);
 
 	/* Disable internal voltage reference and use the external */
-	writeRegister(POWERCONFIG, 0x01<<4, nullptr);
+	updateRegister(POWERCONFIG, 0x01<<4);
 
 	/* Set digital gain to +1 */
-	writeRegister(DAC_DGAIN, 0x4000, nullptr);
+	updateRegister(DAC_DGAIN, 0x4000);
 
 	/* Update settings */
 	writeRegister(RAMUPDATE, 0x01, nullptr);
 
 	/* Pattern run continuously */
-	writeRegister(PAT_TYPE, 0x00, nullptr);
+	updateRegister(PAT_TYPE, 0x00);
 
 	/* No digital offset onto the DAC samples */
-	writeRegister(DACDOF, 0x0000, nullptr);
+	updateRegister(DACDOF, 0x0000);
 
 	/* Timing for SRAM sample reading */
-	writeRegister(PAT_TIMEBASE, 0x0111, nullptr);
+	updateRegister(PAT_TIMEBASE, defaultPatternTimebase);
 
 	/* Default delay between falling edge on trigger and begin of pattern generation */
-	writeRegister(PATTERN_DLY, 0x00E, nullptr);
+	updateRegister(PATTERN_DLY, 0x00E);
 
 	/* Trigger delay is for all patterns */
-	writeRegister(TRIG_TW_SEL, 0x00, nullptr);
+	updateRegister(TRIG_TW_SEL, 0x00);
 
 	/* Update settings */
 	writeRegister(RAMUPDATE, 0x01, nullptr);
+
+	endTransaction();
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
 setOutput(ChannelSettings const& newSettings, std::uint32_t inputFrequency) const -> void
 {
+	if (sramUpload_.active) {
+		/* Apply the settings as soon as the current upload is finished */
+		pendingSettings_ = newSettings;
+		pendingInputFrequency_ = inputFrequency;
+		settingsPending_ = true;
+		chirpPending_ = false;
+		return;
+	}
+
+	std::uint32_t const startCycle = TDeviceCore::cycleCount();
+
+	Configuration config;
+	std::size_t configSize = 0;
+	std::uint64_t patternClocks = 0;
+	SramUpload sramUpload = SramUpload::None;
+	std::uint8_t const sawStep = sawGeneratorStep(newSettings, inputFrequency);
+
+	if (newSettings.form_ == Waveform::Sine) {
+		/* Set frequency and phase */
+		std::uint32_t tuningWord = calculateTuningWord(inputFrequency, newSettings.frequency_);
+		std::uint16_t phaseWord = calculatePhaseWord(newSettings.phase_);
+
+		config = {{
+			{WAV_CONFIG, 0x01 | 0x03<<4},	/* Set output to prestored waveform from DDS */
+			{DDS_CONFIG, 0x00},				/* Tuning word from the registers */
+			{DDS_TW32, static_cast<std::uint16_t>((tuningWord & 0xFFFF00)>>8)},
+			{DDS_TW1, static_cast<std::uint16_t>((tuningWord & 0xFF)<<8)},
+			{DDS_PW, phaseWord}
+		}};
+		configSize = 5;
+
+		patternClocks = burstPatternClocks(newSettings, inputFrequency, burstCycles_);
+		if (burstCycles_ != 0) {
+			/* The DDS counts the periods itself (DDS_CYC) and then stays silent until the end of the pattern */
+			config[0].data = 0x02 | 0x03<<4;
+			config[configSize++] = {DDS_CYC, burstCycles_};
+		}
+	}
+	else if (sawStep != 0) {
+		/* The sawtooth generator needs no samples at all */
+		std::uint16_t sawType = 0x00;	/* Ramp up */
+		if (newSettings.form_ == Waveform::Saw_neg) {
+			sawType = 0x01;				/* Ramp down */
+		}
+		else if (newSettings.form_ == Waveform::Triangle) {
+			sawType = 0x02;
+		}
+
+		config = {{
+			{WAV_CONFIG, 0x01 | 0x01<<4},	/* Set output to prestored waveform from sawtooth generator */
+			{DDS_CONFIG, 0x00},
+			{SAW_CONFIG, static_cast<std::uint16_t>(sawStep<<2 | sawType)}
+		}};
+		configSize = 3;
+
+		patternClocks = burstPatternClocks(newSettings, inputFrequency, burstCycles_);
+		if (burstCycles_ != 0) {
+			/* The sawtooth generator only runs until the end of the pattern period */
+			config[0].data = 0x02 | 0x01<<4;
+		}
+	}
+	else {
+		/* Create samples for waveform, if the SRAM doesn't hold them already */
+		sramUpload = prepareSramPattern(newSettings, inputFrequency);
+
+		config = {{
+			{WAV_CONFIG, 0x00},	/* Set output to SRAM data */
+			{DDS_CONFIG, 0x00},
+			{PAT_TIMEBASE, defaultPatternTimebase},
+			{PAT_PERIOD, sramWave_.numOfSamples},
+			{START_ADDR, static_cast<std::uint16_t>(sramWave_.startAddr<<4)},
+			{STOP_ADDR, static_cast<std::uint16_t>(sramWave_.stopAddr<<4)}
+		}};
+		configSize = 6;
+	}
+
+	appendBurstConfiguration(config, configSize, patternClocks);
+
+	applyConfiguration(config, configSize, sramUpload, startCycle);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+setChirp(ChirpSettings const& chirp, std::uint32_t inputFrequency) const -> bool
+{
+	ChirpPattern pattern;
+	if (not calculateChirpPattern(chirp, inputFrequency, pattern)) {
+		return false;
+	}
+
+	if (sramUpload_.active) {
+		/* Apply the chirp as soon as the current upload is finished */
+		pendingChirp_ = chirp;
+		pendingInputFrequency_ = inputFrequency;
+		chirpPending_ = true;
+		settingsPending_ = false;
+		return true;
+	}
+
+	std::uint32_t const startCycle = TDeviceCore::cycleCount();
+
+	/* Other tuning words are another pattern for the slot allocator */
+	std::uint32_t contentHash = crc32(&pattern.startWord, sizeof(pattern.startWord));
+	contentHash = crc32(&pattern.stopWord, sizeof(pattern.stopWord), contentHash);
+	contentHash = crc32(&pattern.ratio, sizeof(pattern.ratio), contentHash);
+
+	/* The hold time distinguishes the tuning words from the sine, which is never stored in the SRAM */
+	SramResidency requested = {Waveform::Sine, pattern.numOfSteps, 0, pattern.hold, contentHash, true};
+
+	SramUpload const sramUpload = selectSramSlot(requested, pattern.numOfSteps, pattern.numOfSteps);
+	if (sramUpload != SramUpload::None) {
+		sramUpload_.pattern = SampleKernels::Pattern(SampleKernels::TuningWordRamp(pattern.startWord, pattern.stopWord,
+				pattern.numOfSteps, pattern.ratio), pattern.numOfSteps);
+	}
+
+	std::uint16_t const startAddr = sramSlots_.slot(activeSlot_).startAddr;
+	std::uint16_t const stopAddr = startAddr + pattern.numOfSteps - 1;
+
+	/* Chirps always run continuously */
+	std::size_t const configSize = 10;
+	Configuration const config = {{
+		{WAV_CONFIG, 0x01 | 0x03<<4},			/* Prestored waveform from DDS */
+		{DDS_CONFIG, tuningWordFromSram},
+		{TW_RAM_CONFIG, pattern.shift},
+		{DDS_TW32, 0x0000},						/* Bits above the SRAM word */
+		{DDS_TW1, 0x0000},
+		{PAT_TIMEBASE, static_cast<std::uint16_t>((pattern.hold<<8) | 0x11)},
+		{PAT_PERIOD, static_cast<std::uint16_t>(pattern.numOfSteps * pattern.hold)},
+		{START_ADDR, static_cast<std::uint16_t>(startAddr<<4)},
+		{STOP_ADDR, static_cast<std::uint16_t>(stopAddr<<4)},
+		{PAT_TYPE, 0x00}
+	}};
+
+	applyConfiguration(config, configSize, sramUpload, startCycle);
+
+	return true;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+burstPatternClocks(ChannelSettings const& settings, std::uint32_t const inputFrequency,
+		std::uint16_t const numOfCycles) -> std::uint64_t
+{
+	if ((settings.frequency_ == 0) || ((settings.form_ != Waveform::Sine) && (sawGeneratorStep(settings, inputFrequency) == 0))) {
+		return 0;
+	}
+
+	/* Rounded up, the burst has to end within the pattern period */
+	return ((static_cast<std::uint64_t>(numOfCycles) * inputFrequency) + settings.frequency_ - 1) / settings.frequency_;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+triggerBurst(std::uint32_t const inputFrequency) const -> bool
+{
+	if (triggerPin_.isHigh() or (inputFrequency == 0)) {
+		return true;
+	}
+
+	triggerPin_.setHigh();
+
+	if (triggerPulseTime(inputFrequency) > maxTriggerWait) {
+		/* E.g. 1.5ms at the lowest input frequency, the caller ends the pulse without blocking */
+		triggerPulsePending_ = true;
+		return false;
+	}
+
+	/* The DDS samples the trigger with its own clock, so the high level has to last some of its cycles */
+	std::uint32_t const highCycles = static_cast<std::uint32_t>((static_cast<std::uint64_t>(TDeviceCore::systemCoreClock())
+			* triggerPulseClocks) / inputFrequency) + 1;
+
+	std::uint32_t const start = TDeviceCore::cycleCount();
+	while ((TDeviceCore::cycleCount() - start) < highCycles) {
+	}
+	triggerPin_.setLow();
+
+	return true;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+releaseTrigger(void) const -> void
+{
+	if (triggerPulsePending_) {
+		triggerPulsePending_ = false;
+		triggerPin_.setLow();
+	}
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+triggerPulseTime(std::uint32_t const inputFrequency) -> std::uint32_t
+{
+	return static_cast<std::uint32_t>(((static_cast<std::uint64_t>(triggerPulseClocks) * 1000000) + inputFrequency - 1)
+			/ inputFrequency);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+appendBurstConfiguration(Configuration& config, std::size_t& configSize, std::uint64_t const patternClocks) const -> void
+{
+	if (burstCycles_ == 0) {
+		config[configSize++] = {PAT_TYPE, 0x00};	/* Pattern runs continuously */
+		return;
+	}
+
+	/* Pattern repeats the number of times given in DAC_PAT */
+	config[configSize++] = {PAT_TYPE, 0x01};
+
+	if (patternClocks == 0) {
+		/* One period of the SRAM pattern per repetition */
+		std::uint16_t const repetitions = (burstCycles_ > maxBurstCycles) ? maxBurstCycles : burstCycles_;
+		config[configSize++] = {DAC_PAT, static_cast<std::uint16_t>(repetitions - 1)};
+		return;
+	}
+
+	/* A single pattern holding the whole burst. Longer bursts are cut at the longest pattern period */
+	std::uint64_t const clocks = (patternClocks > maxPatternClocks) ? maxPatternClocks : patternClocks;
+	std::uint16_t const periodBase = static_cast<std::uint16_t>((clocks + 0xFFFE) / 0xFFFF);
+
+	config[configSize++] = {DAC_PAT, 0x00};
+	config[configSize++] = {PAT_TIMEBASE, static_cast<std::uint16_t>(0x0101 | (periodBase<<4))};
+	config[configSize++] = {PAT_PERIOD, static_cast<std::uint16_t>((clocks + periodBase - 1) / periodBase)};
+	config[configSize++] = {START_DELAY, 0x0000};
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+applyConfiguration(Configuration const& config, std::size_t const configSize, SramUpload const sramUpload,
+		std::uint32_t const startCycle) const -> void
+{
+	/* Nothing to do, if the DDS already runs with the requested configuration */
+	bool configChanged = false;
+	bool patternTypeChanged = false;
+	for (std::size_t i = 0; i < configSize; i++) {
+		bool const differs = registerDiffers(config[i].address, config[i].data);
+		configChanged |= differs;
+		patternTypeChanged |= differs and (config[i].address == PAT_TYPE);
+	}
+	if (not (configChanged or (sramUpload != SramUpload::None))) {
+		return;
+	}
+
+	/* The pattern generator only takes a new pattern type with a restart */
+	if (outputEnabled_ and (sramUpdateMode_ == SramUpdateMode::DoubleBuffered)
+			and (sramUpload != SramUpload::StopOutput) and (not patternTypeChanged)) {
+		/* Seamless change: The old pattern keeps playing during the upload of the new one,
+		 * the new configuration becomes active with a single register update */
+		auto commit = [this, config, configSize, startCycle]() {
+			this->beginTransaction();
+			for (std::size_t i = 0; i < configSize; i++) {
+				this->updateRegister(config[i].address, config[i].data);
+			}
+
+			this->writeRegister(RAMUPDATE, 0x01, [this, startCycle]() {
+				this->lastInterruptionCycles_ = 0;
+				this->lastUpdateCycles_ = TDeviceCore::cycleCount() - startCycle;
+			});
+		};
+
+		if (sramUpload == SramUpload::Seamless) {
+			uploadSramPattern(true, commit);
+		}
+		else {
+			commit();
+		}
+
+		return;
+	}
+
 	/* Store current status of trigger pin */
 	bool triggerCurrentlyLow = triggerPin_.isLow();
+	std::uint32_t const stopCycle = TDeviceCore::cycleCount();
+
+	/* Stop, configuration and restart (or the start of the upload) are one transaction */
+	beginTransaction();
 
 	if (outputEnabled_) {
 		/* Disable pattern generation */
@@ -456,81 +1406,226 @@ setOutput(ChannelSettings const& newSettings, std::uint32_t inputFrequency) cons
 		triggerPin_.setHigh();
 	}
 
-	if (newSettings.form_ == Waveform::Sine) {
-		/* Set output to prestored waveform from DDS */
-		writeRegister(WAV_CONFIG, 0x01 | 0x03<<4, nullptr);
-
-		/* Set frequency */
-		setTuningWord(inputFrequency, newSettings.frequency_);
-
-		/* Set phase */
-		static constexpr float phaseScaleFactor = std::numeric_limits<std::uint16_t>::max() / 360.0;
-		std::uint16_t phaseWord = static_cast<std::uint16_t>((newSettings.phase_ + 180) * phaseScaleFactor);
-		writeRegister(DDS_PW, phaseWord, nullptr);
+	/* Only write the registers that differ */
+	if (configChanged) {
+		for (std::size_t i = 0; i < configSize; i++) {
+			updateRegister(config[i].address, config[i].data);
+		}
 
 		/* Update settings */
 		writeRegister(RAMUPDATE, 0x01, nullptr);
 	}
-	else {
-		/* Create samples for waveform and configure registers */
-		if (newSettings.form_ == Waveform::Saw_pos) {
-			createRamp(Waveform::Saw_pos, inputFrequency, newSettings.frequency_, newSettings.phase_);
-		}
-		else if (newSettings.form_ == Waveform::Saw_neg) {
-			createRamp(Waveform::Saw_neg, inputFrequency, newSettings.frequency_, newSettings.phase_);
-		}
-		else if (newSettings.form_ == Waveform::Triangle) {
-			createTriangle(inputFrequency, newSettings.frequency_, newSettings.phase_);
+
+	auto restart = [this, triggerCurrentlyLow, startCycle, stopCycle]() {
+		if (this->outputEnabled_) {
+			/* Enable pattern generation */
+			this->writeRegister(PAT_STATUS, 0x01, [this, startCycle, stopCycle]() {
+				this->triggerPin_.setLow();
+
+				std::uint32_t const now = TDeviceCore::cycleCount();
+				this->lastInterruptionCycles_ = now - stopCycle;
+				this->lastUpdateCycles_ = now - startCycle;
+			});
 		}
-		else if (newSettings.form_ == Waveform::Rect) {
-			createPwm(inputFrequency, newSettings.frequency_, newSettings.phase_, newSettings.dutyCycle_);
+		else if (triggerCurrentlyLow) {
+			this->endTransaction();
+			this->triggerPin_.setLow();
 		}
+	};
 
-		/* Set output to SRAM data */
-		writeRegister(WAV_CONFIG, 0x00, nullptr);
+	if (sramUpload != SramUpload::None) {
+		uploadSramPattern(false, restart);
+	}
+	else {
+		restart();
+	}
 
-		/* Set pattern duration */
-		writeRegister(PAT_PERIOD, sramWave_.numOfSamples, nullptr);
+	endTransaction();
+}
 
-		/* Update settings */
-		writeRegister(RAMUPDATE, 0x01, nullptr);
 
-		/* Set start and stop address in SRAM */
-		writeRegister(START_ADDR, sramWave_.startAddr<<4, nullptr);
-		writeRegister(STOP_ADDR, sramWave_.stopAddr<<4, nullptr);
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+template <typename TFunc>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+uploadSramPattern(bool const keepRunning, TFunc&& finished) const -> void
+{
+	sramUpload_.nextWord = 0;
+	sramUpload_.chunksInFlight = 0;
+	sramUpload_.keepRunning = keepRunning;
+	sramUpload_.active = true;
+	sramUpload_.aborted = false;
+	sramUpload_.finished = std::forward<TFunc>(finished);
+
+	beginTransaction();
 
-		/* Enalbe SRAM write access */
-		writeRegister(PAT_STATUS, 0x01<<2, nullptr);
+	/* Enalbe SRAM write access. The RUN bit stays set, if the output keeps running */
+	bool queued = writeRegister(PAT_STATUS, (keepRunning ? 0x01 : 0x00) | 0x01<<2, nullptr);
 
-		/* Update settings */
-		writeRegister(RAMUPDATE, 0x01, nullptr);
+	/* Update settings */
+	queued = writeRegister(RAMUPDATE, 0x01, nullptr) and queued;
 
-		/* Write samples to SRAM */
-		writeSramData(sramWave_.buffer, sramWave_.numOfSamples * 4, nullptr);
+	/* The chunks have to follow the commands above */
+	queued = endTransaction() and queued;
 
-		/* Disable SRAM write access */
-		writeRegister(PAT_STATUS, 0x00, nullptr);
+	if (not queued) {
+		/* Without write access the DDS ignores the chunks. The output is restarted or keeps the previous pattern */
+		abortUpload();
+		return;
+	}
 
-		/* Update settings */
+	/* Fill all chunk buffers, the following chunks are created as soon as a buffer is sent */
+	for (std::size_t i = 0; (i < numOfChunks) && (sramUpload_.nextWord < sramUpload_.numOfWords); i++) {
+		queueChunk(i);
+	}
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+queueChunk(std::size_t const chunkIndex) const -> void
+{
+	std::uint8_t* chunk = chunkBuffers_ + (chunkIndex * chunkBufferSize);
+
+	std::uint16_t count = sramUpload_.numOfWords - sramUpload_.nextWord;
+	if (count > chunkSize) {
+		count = chunkSize;
+	}
+
+	/* Burst header with the SRAM address of the first sample in this chunk */
+	std::uint16_t const address = SRAM_DATA + sramUpload_.slotAddr + sramUpload_.nextWord;
+	chunk[burstHeaderOffset] = static_cast<std::uint8_t>(address>>8);
+	chunk[burstHeaderOffset + 1] = static_cast<std::uint8_t>(address & 0xFF);
+
+	/* Create the samples */
+	sramUpload_.pattern.write(chunk + samplesOffset, count);
+
+	bool const queued = writeSramData(chunk + burstHeaderOffset, 2 + (2 * count), [this, chunkIndex]() {
+		this->chunkSent(chunkIndex);
+	});
+
+	if (not queued) {
+		/* Without this chunk, chunkSent() would never finish the upload */
+		abortUpload();
+		return;
+	}
+
+	sramUpload_.nextWord += count;
+	sramUpload_.chunksInFlight++;
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+chunkSent(std::size_t const chunkIndex) const -> void
+{
+	sramUpload_.chunksInFlight--;
+
+	if (sramUpload_.nextWord < sramUpload_.numOfWords) {
+		/* The other chunk is on the bus now, create the next one in the free buffer */
+		queueChunk(chunkIndex);
+	}
+	else if (sramUpload_.chunksInFlight == 0) {
+		finishUpload();
+	}
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+abortUpload(void) const -> void
+{
+	/* The slot holds an incomplete pattern. A background upload leaves the previous pattern playing */
+	sramSlots_.release(activeSlot_);
+	activeSlot_ = sramUpload_.keepRunning ? sramUpload_.previousSlot : SramSlotAllocator<>::invalidSlot;
+
+	sramUpload_.aborted = true;
+	sramUpload_.nextWord = sramUpload_.numOfWords;
+
+	if (sramUpload_.chunksInFlight == 0) {
+		finishUpload();
+	}
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+finishUpload(void) const -> void
+{
+	/* The commands following the upload join this transaction */
+	beginTransaction();
+
+	/* Disable SRAM write access */
+	writeRegister(PAT_STATUS, sramUpload_.keepRunning ? 0x01 : 0x00, nullptr);
+
+	/* Update settings. When running, this is done together with the new configuration */
+	if (not sramUpload_.keepRunning) {
 		writeRegister(RAMUPDATE, 0x01, nullptr);
 	}
 
-	if (outputEnabled_) {
-		/* Enable pattern generation */
-		writeRegister(PAT_STATUS, 0x01, [&]() {
-			triggerPin_.setLow();
-		});
+	sramUpload_.active = false;
+
+	auto finished = std::move(sramUpload_.finished);
+	sramUpload_.finished = nullptr;
+
+	/* After an aborted background upload the new configuration would point to the incomplete pattern, so it's
+	 * dropped. A stopped output is restarted in any case */
+	if (finished and not (sramUpload_.aborted and sramUpload_.keepRunning)) {
+		finished();
 	}
-	else if (triggerCurrentlyLow) {
-		triggerPin_.setLow();
+
+	/* If the queue is full, the restart is still tried command by command. Anything dropped is counted in
+	 * droppedCommands() and marks the shadow unknown, so the next change of the settings restarts the output */
+	endTransaction();
+
+	/* Apply what was requested in the meantime */
+	if (enablePending_) {
+		enablePending_ = false;
+		setSignalGenerationEnabled(pendingEnabled_);
+	}
+
+	if (settingsPending_) {
+		settingsPending_ = false;
+		setOutput(pendingSettings_, pendingInputFrequency_);
+	}
+	else if (chirpPending_) {
+		chirpPending_ = false;
+		setChirp(pendingChirp_, pendingInputFrequency_);
 	}
 }
 
 
-template <typename TSpiSlaveDriver, typename TIoPin>
-auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin>::
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+setArbitraryWaveform(ArbitraryWaveform const& waveform) const -> void
+{
+	arbitraryWaveform_ = waveform;
+
+	/* Slots with other points are never matched and get evicted over time, the same points find their slot again */
+	arbitraryHash_ = hashArbitraryWaveform(waveform);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
+hashArbitraryWaveform(ArbitraryWaveform const& waveform) -> std::uint32_t
+{
+	std::uint32_t const hash = crc32(&waveform.interpolation, sizeof(waveform.interpolation));
+
+	return crc32(waveform.points, waveform.numOfPoints * sizeof(std::int16_t), hash);
+}
+
+
+template <typename TSpiSlaveDriver, typename TIoPin, typename TDeviceCore>
+auto DirectDigitalSynthesizer<TSpiSlaveDriver, TIoPin, TDeviceCore>::
 setSignalGenerationEnabled(bool enabled) const -> void
 {
+	if (sramUpload_.active) {
+		/* PAT_STATUS must not change during an upload, apply it afterwards */
+		pendingEnabled_ = enabled;
+		enablePending_ = true;
+		return;
+	}
+
 	outputEnabled_ = enabled;
 
 	/* Store current status of trigger pin */
@@ -550,6 +1645,7 @@ setSignalGenerationEnabled(bool enabled) const -> void
 	else {
 		/* Disable pattern generation */
 		triggerPin_.setHigh();
+		beginTransaction();
 		writeRegister(PAT_STATUS, 0x00, nullptr);
 		writeRegister(RAMUPDATE, 0x01, [this, triggerCurrentlyLow](){
 			/* Set pin to low to start pattern generation on the other channel */
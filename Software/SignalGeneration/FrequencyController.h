@@ -4,8 +4,12 @@
 
 
 #include <cstdint>
+#include <cstring>
 #include <cmath>
+#include <array>
 #include "SignalGenerationCommon.h"
+#include "FrequencyPlanner.h"
+#include "FrequencyPlanCache.h"
 
 
 namespace SignalGeneration {
@@ -29,8 +33,19 @@ public:
 	auto getCurrentFrequency(Output const channelNo) const -> std::uint32_t;
 
 	/* Set Si5351 PLL and divider settings to output a appropriate input frequency for the
-	 * synthesizer of given channel */
-	auto setFrequencyForChannel(Output const channelNo, ChannelSettings const& settings) const  -> std::uint32_t;
+	 * synthesizer of given channel. Returns the plan with the achieved signal frequency */
+	auto setFrequencyForChannel(Output const channelNo, ChannelSettings const& settings,
+			SamplePreference const preference = SamplePreference::Resolution) const -> FrequencyPlan;
+
+	/* Set the given input frequency for the synthesizer of the channel, independent of a signal.
+	 * Returns the plan, its input frequency is zero if the Si5351 can't create it */
+	auto setInputFrequencyForChannel(Output const channelNo, std::uint32_t const inputFrequency) const -> FrequencyPlan;
+
+	/* Select whether new frequencies may change the PLLs or only the multisynth dividers */
+	auto setClockPlanning(ClockPlanning const planning) const -> void { clockPlanning_ = planning; }
+
+	/* Number of plans taken from the table of standard frequencies, from the cache and freshly planned */
+	auto getPlanCacheStatistics(void) const -> PlanCacheStatistics const& { return planCache_.statistics(); }
 
 
 private:
@@ -148,18 +163,106 @@ private:
 	auto setDivider(std::uint8_t const output, Si5351PLL_t const pll, std::uint32_t const msDiv,
 			std::uint32_t const msNum, std::uint32_t const msDenom, Si5351RDiv_t const rDiv) const -> void;
 
+	/* Write the registers starting at startAddr, but only the bytes that differ from the register shadow.
+	 * Differing bytes are sent as bursts of contiguous registers. Returns true, if anything was written */
+	auto updateRegisters(std::uint8_t const startAddr, std::uint8_t const* const data, std::size_t const numOfBytes) const -> bool;
+
+	auto updateRegister(std::uint8_t const address, std::uint8_t const data) const -> bool {
+		return updateRegisters(address, &data, 1);
+	}
+
+	/* Number of registers mirrored in the register shadow */
+	static constexpr std::size_t numOfShadowRegisters = SI5351_REGISTER_183_CRYSTAL_INTERNAL_LOAD_CAPACITANCE + 1;
+
+	/* Marks a register of the shadow as unknown */
+	static constexpr std::int16_t unknownRegisterValue = -1;
+
+	/* Unchanged registers in between are sent along, as long as that is shorter than starting a new
+	 * burst (start condition, slave address, register address) */
+	static constexpr std::size_t burstOverhead = 2;
+
+	/* Size of the largest register block written at once */
+	static constexpr std::size_t maxBurstSize = 9;
+
 	/* Array for the divider for each channel */
 	mutable std::array<std::uint32_t, Output::NumOfOutputs> channelFrequencies_;
 
+	/* Last value written into each register */
+	mutable std::array<std::int16_t, numOfShadowRegisters> registerShadow_;
+
+	mutable ClockPlanning clockPlanning_;
+
+	/* Plans of standard and recently used frequencies */
+	FrequencyPlanCache<> planCache_;
+
 	const TI2cSlaveDriver& i2c_;
 };
 
 
+template <typename TI2cSlaveDriver>
+constexpr std::int16_t FrequencyController<TI2cSlaveDriver>::unknownRegisterValue;
+
+
 template <typename TI2cSlaveDriver>
 FrequencyController<TI2cSlaveDriver>::
 FrequencyController(const TI2cSlaveDriver& i2c) :
+	channelFrequencies_(),
+	registerShadow_(),
+	clockPlanning_(ClockPlanning::Flexible),
+	planCache_(),
 	i2c_(i2c)
 {
+	/* Nothing is known about the content of the Si5351 yet */
+	registerShadow_.fill(unknownRegisterValue);
+}
+
+
+template <typename TI2cSlaveDriver>
+auto FrequencyController<TI2cSlaveDriver>::
+updateRegisters(std::uint8_t const startAddr, std::uint8_t const* const data, std::size_t const numOfBytes) const -> bool
+{
+	auto differs = [this, startAddr, data](std::size_t const i) {
+		std::size_t const address = startAddr + i;
+		return (address >= numOfShadowRegisters) || (registerShadow_[address] != static_cast<std::int16_t>(data[i]));
+	};
+
+	bool written = false;
+	std::size_t first = 0;
+
+	while (first < numOfBytes) {
+		if (not differs(first)) {
+			first++;
+			continue;
+		}
+
+		/* Extend the burst up to the last differing byte before a longer run of unchanged ones */
+		std::size_t end = first + 1;
+		for (std::size_t i = end; (i < numOfBytes) && (i - end < burstOverhead); i++) {
+			if (differs(i)) {
+				end = i + 1;
+			}
+		}
+
+		std::uint8_t burst[1 + maxBurstSize];
+		std::size_t const burstSize = end - first;
+		burst[0] = static_cast<std::uint8_t>(startAddr + first);
+		std::memcpy(&burst[1], &data[first], burstSize);
+
+		bool const queued = i2c_.asyncWrite(burst, 1 + burstSize, nullptr, nullptr);
+
+		/* A dropped burst leaves the registers unknown, so the next update writes them again */
+		for (std::size_t i = first; i < end; i++) {
+			if (startAddr + i < numOfShadowRegisters) {
+				registerShadow_[startAddr + i] = queued ? static_cast<std::int16_t>(data[i]) : unknownRegisterValue;
+			}
+		}
+
+		written |= queued;
+
+		first = end;
+	}
+
+	return written;
 }
 
 
@@ -215,11 +318,8 @@ setPLL(Si5351PLL_t const pll, std::uint32_t const mult, std::uint32_t const num,
 	}
 	else {
 		/* Fractional mode */
-		P1 = static_cast<std::uint32_t>((128 * mult) +
-				static_cast<std::uint32_t>(128 * (static_cast<float>(num) / static_cast<float>(denom))) - 512);
-
-		P2 = static_cast<std::uint32_t>((128 * num) -
-				(denom * static_cast<std::uint32_t>(128 * (static_cast<float>(num) / static_cast<float>(denom)))));
+		P1 = (128 * mult) + ((128 * num) / denom) - 512;
+		P2 = (128 * num) - (denom * ((128 * num) / denom));
 
 		P3 = denom;
 	}
@@ -229,7 +329,7 @@ setPLL(Si5351PLL_t const pll, std::uint32_t const mult, std::uint32_t const num,
 
 	/* Send the calculated PLL settings */
 	std::uint8_t pllSettingsBuffer[] = {
-			baseAddr, 	static_cast<std::uint8_t>((P3 & 0x0000FF00)>>8),
+						static_cast<std::uint8_t>((P3 & 0x0000FF00)>>8),
 						static_cast<std::uint8_t>(P3 & 0x000000FF),
 						static_cast<std::uint8_t>((P1 & 0x00030000)>>16),
 						static_cast<std::uint8_t>((P1 & 0x0000FF00)>>8),
@@ -238,10 +338,13 @@ setPLL(Si5351PLL_t const pll, std::uint32_t const mult, std::uint32_t const num,
 						static_cast<std::uint8_t>((P2 & 0x0000FF00) >> 8),
 						static_cast<std::uint8_t>(P2 & 0x000000FF)
 	};
-	i2c_.asyncWrite(pllSettingsBuffer, sizeof(pllSettingsBuffer), nullptr, nullptr);
+	bool const pllChanged = updateRegisters(baseAddr, pllSettingsBuffer, sizeof(pllSettingsBuffer));
 
-	/* Reset both PLLs */
-	i2c_.asyncWriteRegister(SI5351_REGISTER_177_PLL_RESET, 0x01<<7 | 0x01<<5, nullptr, nullptr);
+	/* Reset the PLL only if its parameters changed, as the reset glitches the output.
+	 * The other PLL keeps running undisturbed */
+	if (pllChanged) {
+		i2c_.asyncWriteRegister(SI5351_REGISTER_177_PLL_RESET, (pll == SI5351_PLL_A) ? 0x01<<5 : 0x01<<7, nullptr, nullptr);
+	}
 }
 
 
@@ -295,11 +398,8 @@ setDivider(std::uint8_t const output, Si5351PLL_t const pll, std::uint32_t const
 	}
 	else {
 		/* Fractional mode */
-		P1 = static_cast<uint32_t>((128 * msDiv) +
-				static_cast<std::uint32_t>(128 * (static_cast<float>(msNum) / static_cast<float>(msDenom))) - 512);
-
-		P2 = static_cast<uint32_t>((128 * msNum) -
-				(msDenom * static_cast<std::uint32_t>(128 * (static_cast<float>(msNum) / static_cast<float>(msDenom)))));
+		P1 = (128 * msDiv) + ((128 * msNum) / msDenom) - 512;
+		P2 = (128 * msNum) - (msDenom * ((128 * msNum) / msDenom));
 
 		P3 = msDenom;
 	}
@@ -323,7 +423,7 @@ setDivider(std::uint8_t const output, Si5351PLL_t const pll, std::uint32_t const
 
 	/* Set the MSx config registers */
 	std::uint8_t msSettingsBuffer[] = {
-			baseAddr, 	static_cast<std::uint8_t>((P3 & 0x0000FF00)>>8),
+						static_cast<std::uint8_t>((P3 & 0x0000FF00)>>8),
 						static_cast<std::uint8_t>(P3 & 0x000000FF),
 						static_cast<std::uint8_t>((P1 & 0x00030000)>>16),
 						static_cast<std::uint8_t>((P1 & 0x0000FF00)>>8),
@@ -334,13 +434,13 @@ setDivider(std::uint8_t const output, Si5351PLL_t const pll, std::uint32_t const
 	};
 	if (msDiv == 4) {
 		/* Div by 4 special mode: Set DIVBY4 bits */
-		msSettingsBuffer[3] |= 0x03<<2;
+		msSettingsBuffer[2] |= 0x03<<2;
 	}
 	/* Set R_DIV */
-	msSettingsBuffer[3] |= (rDiv & 0x07)<<4;
+	msSettingsBuffer[2] |= (rDiv & 0x07)<<4;
 
-	/* Write settings */
-	i2c_.asyncWrite(msSettingsBuffer, sizeof(msSettingsBuffer), nullptr, nullptr);
+	/* Write settings that changed */
+	updateRegisters(baseAddr, msSettingsBuffer, sizeof(msSettingsBuffer));
 
 	/* Configure the clk control and enable the output */
 	std::uint8_t clkControlReg = 0x0F;  /* 8mA drive strength, MS0 as CLK0 source, Clock not inverted, powered up */
@@ -351,7 +451,7 @@ setDivider(std::uint8_t const output, Si5351PLL_t const pll, std::uint32_t const
 		clkControlReg |= 1<<6; /* Integer mode */
 	}
 
-	i2c_.asyncWriteRegister(ctrlRegAddr, clkControlReg, nullptr, nullptr);
+	updateRegister(ctrlRegAddr, clkControlReg);
 }
 
 
@@ -359,24 +459,20 @@ template <typename TI2cSlaveDriver>
 auto FrequencyController<TI2cSlaveDriver>::
 initialize(void) const -> void
 {
+	/* The content of the Si5351 is unknown, so everything below is written */
+	registerShadow_.fill(unknownRegisterValue);
+
 	/* Disable all outputs setting CLKx_DIS high */
-	i2c_.asyncWriteRegister(SI5351_REGISTER_3_OUTPUT_ENABLE_CONTROL, 0xFF, nullptr, nullptr);
+	updateRegister(SI5351_REGISTER_3_OUTPUT_ENABLE_CONTROL, 0xFF);
 
 	/* Power down all output drivers */
 	static const std::uint8_t powerDownRegBuffer[] = {
-			SI5351_REGISTER_16_CLK0_CONTROL, 0x80,
-											 0x80,
-						 					 0x80,
-						  					 0x80,
-											 0x80,
-											 0x80,
-											 0x80,
-											 0x80
+			0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
 	};
-	i2c_.asyncWrite(powerDownRegBuffer, sizeof(powerDownRegBuffer), nullptr, nullptr);
+	updateRegisters(SI5351_REGISTER_16_CLK0_CONTROL, powerDownRegBuffer, sizeof(powerDownRegBuffer));
 
 	/* Set the load capacitance for the XTAL */
-	i2c_.asyncWriteRegister(SI5351_REGISTER_183_CRYSTAL_INTERNAL_LOAD_CAPACITANCE, SI5351_CRYSTAL_LOAD_10PF, nullptr, nullptr);
+	updateRegister(SI5351_REGISTER_183_CRYSTAL_INTERNAL_LOAD_CAPACITANCE, SI5351_CRYSTAL_LOAD_10PF);
 
 	/* Set both outputs to 180MHz */
 	setPLL(SI5351_PLL_A, 28, 8, 10);
@@ -388,7 +484,7 @@ initialize(void) const -> void
 	channelFrequencies_[Output::Ch2] = 180e6;
 
 	/* Enable outputs*/
-	i2c_.asyncWriteRegister(SI5351_REGISTER_3_OUTPUT_ENABLE_CONTROL, 0x00, nullptr, nullptr);
+	updateRegister(SI5351_REGISTER_3_OUTPUT_ENABLE_CONTROL, 0x00);
 }
 
 
@@ -402,100 +498,61 @@ getCurrentFrequency(Output const channelNo) const -> std::uint32_t
 
 template <typename TI2cSlaveDriver>
 auto FrequencyController<TI2cSlaveDriver>::
-setFrequencyForChannel(Output const channelNo, ChannelSettings const& settings) const -> std::uint32_t
+setFrequencyForChannel(Output const channelNo, ChannelSettings const& settings,
+		SamplePreference const preference) const -> FrequencyPlan
 {
-	std::uint32_t pllMult, pllNum, pllDenom, msMult, msNum, msDenom;
-	Si5351RDiv_t rDiv = SI5351_R_DIV_1;
-
 	/* Specify which PLL and Si5351 output channel to use */
 	Si5351PLL_t pll = (channelNo == Output::Ch1) ? SI5351_PLL_A : SI5351_PLL_B;
 	std::uint8_t outputChannel = (channelNo == Output::Ch1) ? 0 : 1;
 
-	/* Simplest implementation:
-	 * 	Synthesizer input frequency = Target output frequency * optimal number of samples
-	 *
-	 * 	optimal number of samples = 720;
-	 */
-	static const std::uint64_t optimalNumberOfSamples 	= 720;
-	static const std::uint64_t maximumInputFrequency 	= 180000000;
-	static const std::uint32_t minimumInputFrequency	= 2000;
-
-	/* Calculate input frequency */
-	std::uint64_t tempValue = settings.frequency_ * optimalNumberOfSamples;
-	if (tempValue < static_cast<std::uint64_t>(minimumInputFrequency)) {
-		tempValue = minimumInputFrequency;
+	/* Sine fast path: If the channel already runs at the maximum input frequency and the tuning word
+	 * alone reaches the new frequency, the Si5351 stays untouched and no planning is needed */
+	FrequencyPlan fastPlan;
+	if ((settings.form_ == Waveform::Sine) && FrequencyPlanner::fixedClockSinePlan(settings.frequency_, clockPlanning_, fastPlan)
+			&& (fastPlan.inputFrequency == channelFrequencies_[channelNo])) {
+		return fastPlan;
 	}
-	else if (tempValue > maximumInputFrequency) {
-		tempValue = maximumInputFrequency;
-	}
-	std::uint32_t inputFrequency = static_cast<std::uint32_t>(tempValue & 0xFFFFFFFF);
+
+	/* Jointly choose the synthesizer input frequency and the number of samples per period.
+	 * With a fixed VCO, the PLL registers stay the same, so neither a PLL write nor a reset follows */
+	FrequencyPlan const plan = planCache_.plan(settings, preference, clockPlanning_);
 
 	/* Store new frequency */
-	channelFrequencies_[channelNo] = inputFrequency;
+	channelFrequencies_[channelNo] = plan.inputFrequency;
 
-	/* Get proper R_div */
-	if (inputFrequency >= minimumInputFrequency<<7 ) {
-		rDiv = SI5351_R_DIV_1;
-	}
-	else if (inputFrequency < minimumInputFrequency<<1) {
-		rDiv = SI5351_R_DIV_128;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<1) && (inputFrequency < minimumInputFrequency<<2)) {
-		rDiv = SI5351_R_DIV_64;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<2) && (inputFrequency < minimumInputFrequency<<3)) {
-		rDiv = SI5351_R_DIV_32;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<3) && (inputFrequency < minimumInputFrequency<<4)) {
-		rDiv = SI5351_R_DIV_16;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<4) && (inputFrequency < minimumInputFrequency<<5)) {
-		rDiv = SI5351_R_DIV_8;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<5) && (inputFrequency < minimumInputFrequency<<6)) {
-		rDiv = SI5351_R_DIV_4;
-	}
-	else if ((inputFrequency >= minimumInputFrequency<<6) && (inputFrequency < minimumInputFrequency<<7)) {
-		rDiv = SI5351_R_DIV_2;
-	}
+	/* Apply new settings */
+	setPLL(pll, plan.clock.pllMult, plan.clock.pllNum, plan.clock.pllDenom);
+	setDivider(outputChannel, pll, plan.clock.msDiv, plan.clock.msNum, plan.clock.msDenom,
+			static_cast<Si5351RDiv_t>(plan.clock.rDiv));
 
-	/* Take R_Div into account */
-	inputFrequency <<= rDiv;
+	return plan;
+}
 
-	/* Setup Clock Generator */
-	if (inputFrequency > 112500000) {
-		/* For frequencies greater than 112.5MHz, we need the special DIVBY4 mode */
-		float pllMultiplier = 4.0 * (static_cast<float>(inputFrequency) / 25000000.0);
-		pllMult = static_cast<std::uint32_t>(pllMultiplier);
-		pllDenom = 10000;
-		pllNum = static_cast<std::uint32_t>((pllMultiplier - static_cast<float>(pllMult)) * pllDenom);
 
-		msMult = 4;
-		msNum = 0;
-		msDenom = 1;
-	}
-	else {
-		/* Set a integer PLL multiplier between 15 and 36 */
-		float temp = ((static_cast<float>(inputFrequency) * 1500.0) / 25000000.0) + 0.5;
-		if (temp > 36.0) {
-			temp = 36.0; /* upper boundary */
-		}
-		pllMult = static_cast<std::uint32_t>(temp);
-		pllNum = 0;
-		pllDenom = 1;
-
-		/* Calculate appropriate Multisynth divider */
-		float msDiv = (25000000.0 * pllMult) / static_cast<float>(inputFrequency);
-		msMult = static_cast<std::uint32_t>(msDiv);
-		msDenom = 10000;
-		msNum = static_cast<std::uint32_t>((msDiv - static_cast<float>(msMult)) * msDenom);
+template <typename TI2cSlaveDriver>
+auto FrequencyController<TI2cSlaveDriver>::
+setInputFrequencyForChannel(Output const channelNo, std::uint32_t const inputFrequency) const -> FrequencyPlan
+{
+	Si5351PLL_t pll = (channelNo == Output::Ch1) ? SI5351_PLL_A : SI5351_PLL_B;
+	std::uint8_t outputChannel = (channelNo == Output::Ch1) ? 0 : 1;
+
+	/* Like the signal plans, fall back to flexible planning if the fixed VCO can't reach the frequency */
+	FrequencyPlan plan = {};
+	if (not FrequencyPlanner::inputFrequencyPlan(inputFrequency, clockPlanning_, plan)
+			&& not FrequencyPlanner::inputFrequencyPlan(inputFrequency, ClockPlanning::Flexible, plan)) {
+		plan.inputFrequency = 0;
+		return plan;
 	}
 
-	/* Apply new settings */
-	setPLL(pll, pllMult, pllNum, pllDenom);
-	setDivider(outputChannel, pll, msMult, msNum, msDenom, rDiv);
+	/* Store new frequency */
+	channelFrequencies_[channelNo] = plan.inputFrequency;
 
-	return channelFrequencies_[channelNo];
+	/* Apply new settings, the register shadow drops what is unchanged */
+	setPLL(pll, plan.clock.pllMult, plan.clock.pllNum, plan.clock.pllDenom);
+	setDivider(outputChannel, pll, plan.clock.msDiv, plan.clock.msNum, plan.clock.msDenom,
+			static_cast<Si5351RDiv_t>(plan.clock.rDiv));
+
+	return plan;
 }
 
 
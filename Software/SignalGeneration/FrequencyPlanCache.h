@@ -0,0 +1,402 @@
+#ifndef FREQUENCYPLANCACHE_H_
+#define FREQUENCYPLANCACHE_H_
+
+#include <cstdint>
+#include <array>
+
+#include "SignalGenerationCommon.h"
+#include "FrequencyPlanner.h"
+
+
+namespace SignalGeneration {
+
+
+/* Usage of the plan cache */
+struct PlanCacheStatistics {
+	std::uint32_t	tableHits;		/* Standard frequencies found in the table */
+	std::uint32_t	cacheHits;		/* Other frequencies planned before */
+	std::uint32_t	misses;			/* Frequencies that had to be planned */
+};
+
+
+/* Kinds of signals the planner treats differently. All SRAM waveforms share their plans */
+enum class PlanClass : std::uint8_t {
+	Sine,
+	Sram,
+	Ramp,			/* Sawtooth generator, Saw_pos and Saw_neg */
+	Triangle,		/* Sawtooth generator, Triangle */
+
+	NumOfPlanClasses
+};
+
+
+/* Standard frequencies (1-2-5 steps from 1Hz to 20MHz) */
+static constexpr std::size_t numOfStandardFrequencies = 23;
+
+static const std::uint32_t standardFrequencies[numOfStandardFrequencies] = {
+	1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+	100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000, 20000000
+};
+
+
+/* Results of FrequencyPlanner::plan() for the standard frequencies with SamplePreference::Resolution,
+ * indexed by [ClockPlanning][PlanClass][standard frequency]. They have to be regenerated when the planner changes */
+static const FrequencyPlan standardFrequencyPlans[2][static_cast<std::size_t>(PlanClass::NumOfPlanClasses)][numOfStandardFrequencies] = {
+	{	/* ClockPlanning::Flexible */
+		{	/* Sine */
+			{4096, 4096, {24, 0, 1, 1144, 419, 1024, 7}, 1, 0},
+			{4096, 2048, {24, 0, 1, 1144, 419, 1024, 7}, 2, 0},
+			{5120, 1024, {24, 0, 1, 915, 135, 256, 7}, 5, 0},
+			{10240, 1024, {24, 0, 1, 915, 135, 256, 6}, 10, 0},
+			{20480, 1024, {24, 0, 1, 915, 135, 256, 5}, 20, 0},
+			{51200, 1024, {24, 0, 1, 1464, 27, 32, 3}, 50, 0},
+			{102400, 1024, {24, 0, 1, 1464, 27, 32, 2}, 100, 0},
+			{204800, 1024, {24, 0, 1, 1464, 27, 32, 1}, 200, 0},
+			{512000, 1024, {24, 0, 1, 1171, 7, 8, 0}, 500, 0},
+			{1024000, 1024, {24, 0, 1, 585, 15, 16, 0}, 1000, 0},
+			{2048000, 1024, {24, 0, 1, 292, 31, 32, 0}, 2000, 0},
+			{5120000, 1024, {24, 0, 1, 117, 3, 16, 0}, 5000, 0},
+			{10240000, 1024, {24, 0, 1, 58, 19, 32, 0}, 10000, 0},
+			{20480000, 1024, {24, 0, 1, 29, 19, 64, 0}, 20000, 0},
+			{51200000, 1024, {24, 0, 1, 11, 23, 32, 0}, 50000, 0},
+			{180000000, 1800, {28, 4, 5, 4, 0, 1, 0}, 100003, 3480},
+			{180000000, 900, {28, 4, 5, 4, 0, 1, 0}, 199996, -3767},
+			{180000000, 360, {28, 4, 5, 4, 0, 1, 0}, 499996, -4053},
+			{180000000, 180, {28, 4, 5, 4, 0, 1, 0}, 1000003, 2622},
+			{180000000, 90, {28, 4, 5, 4, 0, 1, 0}, 2000005, 5244},
+			{180000000, 36, {28, 4, 5, 4, 0, 1, 0}, 5000002, 2380},
+			{180000000, 18, {28, 4, 5, 4, 0, 1, 0}, 10000005, 4760},
+			{180000000, 9, {28, 4, 5, 4, 0, 1, 0}, 19999999, -1180}
+		},
+		{	/* Sram */
+			{2605, 2605, {24, 0, 1, 1799, 221, 521, 7}, 1, 0},
+			{4096, 2048, {24, 0, 1, 1144, 419, 1024, 7}, 2, 0},
+			{10240, 2048, {24, 0, 1, 915, 135, 256, 6}, 5, 0},
+			{20480, 2048, {24, 0, 1, 915, 135, 256, 5}, 10, 0},
+			{40960, 2048, {24, 0, 1, 915, 135, 256, 4}, 20, 0},
+			{102400, 2048, {24, 0, 1, 1464, 27, 32, 2}, 50, 0},
+			{204800, 2048, {24, 0, 1, 1464, 27, 32, 1}, 100, 0},
+			{409600, 2048, {24, 0, 1, 1464, 27, 32, 0}, 200, 0},
+			{1024000, 2048, {24, 0, 1, 585, 15, 16, 0}, 500, 0},
+			{2048000, 2048, {24, 0, 1, 292, 31, 32, 0}, 1000, 0},
+			{2048000, 1024, {24, 0, 1, 292, 31, 32, 0}, 2000, 0},
+			{5120000, 1024, {24, 0, 1, 117, 3, 16, 0}, 5000, 0},
+			{10240000, 1024, {24, 0, 1, 58, 19, 32, 0}, 10000, 0},
+			{20480000, 1024, {24, 0, 1, 29, 19, 64, 0}, 20000, 0},
+			{51200000, 1024, {24, 0, 1, 11, 23, 32, 0}, 50000, 0},
+			{102400000, 1024, {33, 0, 1, 8, 29, 512, 0}, 100000, 0},
+			{180000000, 900, {28, 4, 5, 4, 0, 1, 0}, 200000, 0},
+			{180000000, 360, {28, 4, 5, 4, 0, 1, 0}, 500000, 0},
+			{180000000, 180, {28, 4, 5, 4, 0, 1, 0}, 1000000, 0},
+			{180000000, 90, {28, 4, 5, 4, 0, 1, 0}, 2000000, 0},
+			{180000000, 36, {28, 4, 5, 4, 0, 1, 0}, 5000000, 0},
+			{180000000, 18, {28, 4, 5, 4, 0, 1, 0}, 10000000, 0},
+			{180000000, 9, {28, 4, 5, 4, 0, 1, 0}, 20000000, 0}
+		},
+		{	/* Ramp */
+			{1032192, 1032192, {24, 0, 1, 581, 193, 672, 0}, 1, 0},
+			{2064384, 1032192, {24, 0, 1, 290, 865, 1344, 0}, 2, 0},
+			{5160960, 1032192, {24, 0, 1, 116, 173, 672, 0}, 5, 0},
+			{10321920, 1032192, {24, 0, 1, 58, 173, 1344, 0}, 10, 0},
+			{20643840, 1032192, {24, 0, 1, 29, 173, 2688, 0}, 20, 0},
+			{51609600, 1032192, {24, 0, 1, 11, 841, 1344, 0}, 50, 0},
+			{103219200, 1032192, {34, 0, 1, 8, 7577, 32256, 0}, 100, 0},
+			{176947200, 884736, {28, 4868, 15625, 4, 0, 1, 0}, 200, 0},
+			{172032000, 344064, {27, 1641, 3125, 4, 0, 1, 0}, 500, 0},
+			{163840000, 163840, {26, 134, 625, 4, 0, 1, 0}, 1000, 0},
+			{163840000, 81920, {26, 134, 625, 4, 0, 1, 0}, 2000, 0},
+			{163840000, 32768, {26, 134, 625, 4, 0, 1, 0}, 5000, 0},
+			{163840000, 16384, {26, 134, 625, 4, 0, 1, 0}, 10000, 0},
+			{20480000, 1024, {24, 0, 1, 29, 19, 64, 0}, 20000, 0},
+			{51200000, 1024, {24, 0, 1, 11, 23, 32, 0}, 50000, 0},
+			{102400000, 1024, {33, 0, 1, 8, 29, 512, 0}, 100000, 0},
+			{180000000, 900, {28, 4, 5, 4, 0, 1, 0}, 200000, 0},
+			{180000000, 360, {28, 4, 5, 4, 0, 1, 0}, 500000, 0},
+			{180000000, 180, {28, 4, 5, 4, 0, 1, 0}, 1000000, 0},
+			{180000000, 90, {28, 4, 5, 4, 0, 1, 0}, 2000000, 0},
+			{180000000, 36, {28, 4, 5, 4, 0, 1, 0}, 5000000, 0},
+			{180000000, 18, {28, 4, 5, 4, 0, 1, 0}, 10000000, 0},
+			{180000000, 9, {28, 4, 5, 4, 0, 1, 0}, 20000000, 0}
+		},
+		{	/* Triangle */
+			{2064384, 2064384, {24, 0, 1, 290, 865, 1344, 0}, 1, 0},
+			{4128768, 2064384, {24, 0, 1, 145, 865, 2688, 0}, 2, 0},
+			{10321920, 2064384, {24, 0, 1, 58, 173, 1344, 0}, 5, 0},
+			{20643840, 2064384, {24, 0, 1, 29, 173, 2688, 0}, 10, 0},
+			{41287680, 2064384, {24, 0, 1, 14, 2861, 5376, 0}, 20, 0},
+			{103219200, 2064384, {34, 0, 1, 8, 7577, 32256, 0}, 50, 0},
+			{176947200, 1769472, {28, 4868, 15625, 4, 0, 1, 0}, 100, 0},
+			{176947200, 884736, {28, 4868, 15625, 4, 0, 1, 0}, 200, 0},
+			{163840000, 327680, {26, 134, 625, 4, 0, 1, 0}, 500, 0},
+			{163840000, 163840, {26, 134, 625, 4, 0, 1, 0}, 1000, 0},
+			{65536000, 32768, {24, 0, 1, 9, 159, 1024, 0}, 2000, 0},
+			{163840000, 32768, {26, 134, 625, 4, 0, 1, 0}, 5000, 0},
+			{10240000, 1024, {24, 0, 1, 58, 19, 32, 0}, 10000, 0},
+			{20480000, 1024, {24, 0, 1, 29, 19, 64, 0}, 20000, 0},
+			{51200000, 1024, {24, 0, 1, 11, 23, 32, 0}, 50000, 0},
+			{102400000, 1024, {33, 0, 1, 8, 29, 512, 0}, 100000, 0},
+			{180000000, 900, {28, 4, 5, 4, 0, 1, 0}, 200000, 0},
+			{180000000, 360, {28, 4, 5, 4, 0, 1, 0}, 500000, 0},
+			{180000000, 180, {28, 4, 5, 4, 0, 1, 0}, 1000000, 0},
+			{180000000, 90, {28, 4, 5, 4, 0, 1, 0}, 2000000, 0},
+			{180000000, 36, {28, 4, 5, 4, 0, 1, 0}, 5000000, 0},
+			{180000000, 18, {28, 4, 5, 4, 0, 1, 0}, 10000000, 0},
+			{180000000, 9, {28, 4, 5, 4, 0, 1, 0}, 20000000, 0}
+		}
+	},
+	{	/* ClockPlanning::FixedVco */
+		{	/* Sine */
+			{4096, 4096, {36, 0, 1, 1716, 1257, 2048, 7}, 1, 0},
+			{4096, 2048, {36, 0, 1, 1716, 1257, 2048, 7}, 2, 0},
+			{5120, 1024, {36, 0, 1, 1373, 149, 512, 7}, 5, 0},
+			{10240, 1024, {36, 0, 1, 1373, 149, 512, 6}, 10, 0},
+			{20480, 1024, {36, 0, 1, 1373, 149, 512, 5}, 20, 0},
+			{51200, 1024, {36, 0, 1, 1098, 81, 128, 4}, 50, 0},
+			{102400, 1024, {36, 0, 1, 1098, 81, 128, 3}, 100, 0},
+			{204800, 1024, {36, 0, 1, 1098, 81, 128, 2}, 200, 0},
+			{512000, 1024, {36, 0, 1, 1757, 13, 16, 0}, 500, 0},
+			{1024000, 1024, {36, 0, 1, 878, 29, 32, 0}, 1000, 0},
+			{2048000, 1024, {36, 0, 1, 439, 29, 64, 0}, 2000, 0},
+			{5120000, 1024, {36, 0, 1, 175, 25, 32, 0}, 5000, 0},
+			{10240000, 1024, {36, 0, 1, 87, 57, 64, 0}, 10000, 0},
+			{20480000, 1024, {36, 0, 1, 43, 121, 128, 0}, 20000, 0},
+			{51200000, 1024, {36, 0, 1, 17, 37, 64, 0}, 50000, 0},
+			{112500000, 1125, {36, 0, 1, 8, 0, 1, 0}, 99999, -542},
+			{112500000, 562, {36, 0, 1, 8, 0, 1, 0}, 199999, -1084},
+			{112500000, 225, {36, 0, 1, 8, 0, 1, 0}, 499997, -2712},
+			{112500000, 112, {36, 0, 1, 8, 0, 1, 0}, 1000001, 1281},
+			{112500000, 56, {36, 0, 1, 8, 0, 1, 0}, 2000003, 2562},
+			{112500000, 22, {36, 0, 1, 8, 0, 1, 0}, 5000000, -295},
+			{112500000, 11, {36, 0, 1, 8, 0, 1, 0}, 9999999, -590},
+			{112500000, 5, {36, 0, 1, 8, 0, 1, 0}, 19999999, -1180}
+		},
+		{	/* Sram */
+			{3907, 3907, {36, 0, 1, 1799, 2557, 3907, 7}, 1, 0},
+			{4096, 2048, {36, 0, 1, 1716, 1257, 2048, 7}, 2, 0},
+			{10240, 2048, {36, 0, 1, 1373, 149, 512, 6}, 5, 0},
+			{20480, 2048, {36, 0, 1, 1373, 149, 512, 5}, 10, 0},
+			{40960, 2048, {36, 0, 1, 1373, 149, 512, 4}, 20, 0},
+			{102400, 2048, {36, 0, 1, 1098, 81, 128, 3}, 50, 0},
+			{204800, 2048, {36, 0, 1, 1098, 81, 128, 2}, 100, 0},
+			{409600, 2048, {36, 0, 1, 1098, 81, 128, 1}, 200, 0},
+			{1024000, 2048, {36, 0, 1, 878, 29, 32, 0}, 500, 0},
+			{2048000, 2048, {36, 0, 1, 439, 29, 64, 0}, 1000, 0},
+			{2048000, 1024, {36, 0, 1, 439, 29, 64, 0}, 2000, 0},
+			{5120000, 1024, {36, 0, 1, 175, 25, 32, 0}, 5000, 0},
+			{10240000, 1024, {36, 0, 1, 87, 57, 64, 0}, 10000, 0},
+			{20480000, 1024, {36, 0, 1, 43, 121, 128, 0}, 20000, 0},
+			{51200000, 1024, {36, 0, 1, 17, 37, 64, 0}, 50000, 0},
+			{102400000, 1024, {36, 0, 1, 8, 101, 128, 0}, 100000, 0},
+			{112400000, 562, {36, 0, 1, 8, 2, 281, 0}, 200000, 0},
+			{112500000, 225, {36, 0, 1, 8, 0, 1, 0}, 500000, 0},
+			{112000000, 112, {36, 0, 1, 8, 1, 28, 0}, 1000000, 0},
+			{112000000, 56, {36, 0, 1, 8, 1, 28, 0}, 2000000, 0},
+			{110000000, 22, {36, 0, 1, 8, 2, 11, 0}, 5000000, 0},
+			{110000000, 11, {36, 0, 1, 8, 2, 11, 0}, 10000000, 0},
+			{100000000, 5, {36, 0, 1, 9, 0, 1, 0}, 20000000, 0}
+		},
+		{	/* Ramp */
+			{1032192, 1032192, {36, 0, 1, 871, 417, 448, 0}, 1, 0},
+			{2064384, 1032192, {36, 0, 1, 435, 865, 896, 0}, 2, 0},
+			{5160960, 1032192, {36, 0, 1, 174, 173, 448, 0}, 5, 0},
+			{10321920, 1032192, {36, 0, 1, 87, 173, 896, 0}, 10, 0},
+			{20643840, 1032192, {36, 0, 1, 43, 1069, 1792, 0}, 20, 0},
+			{51609600, 1032192, {36, 0, 1, 17, 393, 896, 0}, 50, 0},
+			{103219200, 1032192, {36, 0, 1, 8, 1289, 1792, 0}, 100, 0},
+			{111411200, 557056, {36, 0, 1, 8, 1361, 17408, 0}, 200, 0},
+			{106496000, 212992, {36, 0, 1, 8, 1501, 3328, 0}, 500, 0},
+			{98304000, 98304, {36, 0, 1, 9, 159, 1024, 0}, 1000, 0},
+			{98304000, 49152, {36, 0, 1, 9, 159, 1024, 0}, 2000, 0},
+			{81920000, 16384, {36, 0, 1, 10, 505, 512, 0}, 5000, 0},
+			{10240000, 1024, {36, 0, 1, 87, 57, 64, 0}, 10000, 0},
+			{20480000, 1024, {36, 0, 1, 43, 121, 128, 0}, 20000, 0},
+			{51200000, 1024, {36, 0, 1, 17, 37, 64, 0}, 50000, 0},
+			{102400000, 1024, {36, 0, 1, 8, 101, 128, 0}, 100000, 0},
+			{112400000, 562, {36, 0, 1, 8, 2, 281, 0}, 200000, 0},
+			{112500000, 225, {36, 0, 1, 8, 0, 1, 0}, 500000, 0},
+			{112000000, 112, {36, 0, 1, 8, 1, 28, 0}, 1000000, 0},
+			{112000000, 56, {36, 0, 1, 8, 1, 28, 0}, 2000000, 0},
+			{110000000, 22, {36, 0, 1, 8, 2, 11, 0}, 5000000, 0},
+			{110000000, 11, {36, 0, 1, 8, 2, 11, 0}, 10000000, 0},
+			{100000000, 5, {36, 0, 1, 9, 0, 1, 0}, 20000000, 0}
+		},
+		{	/* Triangle */
+			{2064384, 2064384, {36, 0, 1, 435, 865, 896, 0}, 1, 0},
+			{4128768, 2064384, {36, 0, 1, 217, 1761, 1792, 0}, 2, 0},
+			{10321920, 2064384, {36, 0, 1, 87, 173, 896, 0}, 5, 0},
+			{20643840, 2064384, {36, 0, 1, 43, 1069, 1792, 0}, 10, 0},
+			{41287680, 2064384, {36, 0, 1, 21, 2861, 3584, 0}, 20, 0},
+			{103219200, 2064384, {36, 0, 1, 8, 1289, 1792, 0}, 50, 0},
+			{111411200, 1114112, {36, 0, 1, 8, 1361, 17408, 0}, 100, 0},
+			{111411200, 557056, {36, 0, 1, 8, 1361, 17408, 0}, 200, 0},
+			{98304000, 196608, {36, 0, 1, 9, 159, 1024, 0}, 500, 0},
+			{98304000, 98304, {36, 0, 1, 9, 159, 1024, 0}, 1000, 0},
+			{65536000, 32768, {36, 0, 1, 13, 1501, 2048, 0}, 2000, 0},
+			{5120000, 1024, {36, 0, 1, 175, 25, 32, 0}, 5000, 0},
+			{10240000, 1024, {36, 0, 1, 87, 57, 64, 0}, 10000, 0},
+			{20480000, 1024, {36, 0, 1, 43, 121, 128, 0}, 20000, 0},
+			{51200000, 1024, {36, 0, 1, 17, 37, 64, 0}, 50000, 0},
+			{102400000, 1024, {36, 0, 1, 8, 101, 128, 0}, 100000, 0},
+			{112400000, 562, {36, 0, 1, 8, 2, 281, 0}, 200000, 0},
+			{112500000, 225, {36, 0, 1, 8, 0, 1, 0}, 500000, 0},
+			{112000000, 112, {36, 0, 1, 8, 1, 28, 0}, 1000000, 0},
+			{112000000, 56, {36, 0, 1, 8, 1, 28, 0}, 2000000, 0},
+			{110000000, 22, {36, 0, 1, 8, 2, 11, 0}, 5000000, 0},
+			{110000000, 11, {36, 0, 1, 8, 2, 11, 0}, 10000000, 0},
+			{100000000, 5, {36, 0, 1, 9, 0, 1, 0}, 20000000, 0}
+		}
+	}
+};
+
+
+/* Class FrequencyPlanCache
+ * 	Returns frequency plans without running the planner for frequencies planned before. Standard
+ * 	frequencies come from a precomputed table, all others are kept in a small cache. If the cache is
+ * 	full, the least recently used plan is replaced.
+ *
+ * 	@template TNumOfEntries - Number of plans for non-standard frequencies kept at the same time
+ */
+template <std::size_t TNumOfEntries = 8>
+class FrequencyPlanCache
+{
+public:
+
+	/* Constructor */
+	FrequencyPlanCache();
+
+	/* Plan for the given signal, either from the table, from the cache or freshly planned */
+	auto plan(ChannelSettings const& settings, SamplePreference const preference, ClockPlanning const planning) const -> FrequencyPlan;
+
+	auto statistics(void) const -> PlanCacheStatistics const& { return statistics_; }
+
+	/* Kind of signal regarding the planning */
+	static auto planClass(ChannelSettings const& settings) -> PlanClass;
+
+
+private:
+
+	struct Entry {
+		std::uint32_t		frequency;
+		PlanClass			planClass;
+		SamplePreference	preference;
+		ClockPlanning		planning;
+		bool				valid;
+		std::uint32_t		lastUse;
+		FrequencyPlan		plan;
+	};
+
+	/* Index of the standard frequency, or numOfStandardFrequencies if it is none */
+	static auto standardFrequencyIndex(std::uint32_t const frequency) -> std::size_t;
+
+	mutable std::array<Entry, TNumOfEntries> entries_;
+	mutable std::uint32_t useCounter_;
+	mutable PlanCacheStatistics statistics_;
+};
+
+
+template <std::size_t TNumOfEntries>
+FrequencyPlanCache<TNumOfEntries>::
+FrequencyPlanCache() :
+	entries_(),
+	useCounter_(0),
+	statistics_({0, 0, 0})
+{
+	for (auto& entry : entries_) {
+		entry.valid = false;
+	}
+}
+
+
+template <std::size_t TNumOfEntries>
+auto FrequencyPlanCache<TNumOfEntries>::
+planClass(ChannelSettings const& settings) -> PlanClass
+{
+	if (settings.form_ == Waveform::Sine) {
+		return PlanClass::Sine;
+	}
+
+	switch (sawCyclesPerStep(settings)) {
+		case sawNumOfCodes:
+			return PlanClass::Ramp;
+		case 2 * sawNumOfCodes:
+			return PlanClass::Triangle;
+		default:
+			return PlanClass::Sram;
+	}
+}
+
+
+template <std::size_t TNumOfEntries>
+auto FrequencyPlanCache<TNumOfEntries>::
+standardFrequencyIndex(std::uint32_t const frequency) -> std::size_t
+{
+	/* Binary search in the sorted list of standard frequencies */
+	std::size_t low = 0;
+	std::size_t high = numOfStandardFrequencies;
+
+	while (low < high) {
+		std::size_t const middle = (low + high) / 2;
+		if (standardFrequencies[middle] < frequency) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	if ((low < numOfStandardFrequencies) && (standardFrequencies[low] == frequency)) {
+		return low;
+	}
+
+	return numOfStandardFrequencies;
+}
+
+
+template <std::size_t TNumOfEntries>
+auto FrequencyPlanCache<TNumOfEntries>::
+plan(ChannelSettings const& settings, SamplePreference const preference, ClockPlanning const planning) const -> FrequencyPlan
+{
+	PlanClass const signalClass = planClass(settings);
+
+	/* Standard frequencies */
+	if (preference == SamplePreference::Resolution) {
+		std::size_t const index = standardFrequencyIndex(settings.frequency_);
+		if (index < numOfStandardFrequencies) {
+			statistics_.tableHits++;
+			return standardFrequencyPlans[static_cast<std::size_t>(planning)][static_cast<std::size_t>(signalClass)][index];
+		}
+	}
+
+	/* Frequencies planned before */
+	Entry* oldest = &entries_[0];
+	for (auto& entry : entries_) {
+		if (entry.valid && (entry.frequency == settings.frequency_) && (entry.planClass == signalClass)
+				&& (entry.preference == preference) && (entry.planning == planning)) {
+			statistics_.cacheHits++;
+			entry.lastUse = ++useCounter_;
+			return entry.plan;
+		}
+
+		/* Remember the entry to replace: an empty one or the least recently used */
+		if (oldest->valid && (not entry.valid || (entry.lastUse < oldest->lastUse))) {
+			oldest = &entry;
+		}
+	}
+
+	statistics_.misses++;
+
+	oldest->frequency = settings.frequency_;
+	oldest->planClass = signalClass;
+	oldest->preference = preference;
+	oldest->planning = planning;
+	oldest->valid = true;
+	oldest->lastUse = ++useCounter_;
+	oldest->plan = FrequencyPlanner::plan(settings, preference, planning);
+
+	return oldest->plan;
+}
+
+
+} /* namespace SignalGeneration */
+
+#endif /* FREQUENCYPLANCACHE_H_ */
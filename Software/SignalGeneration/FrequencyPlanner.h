@@ -0,0 +1,498 @@
+#ifndef FREQUENCYPLANNER_H_
+#define FREQUENCYPLANNER_H_
+
+#include <cstdint>
+
+#include "SignalGenerationCommon.h"
+
+
+namespace SignalGeneration {
+
+
+/* Preferred number of SRAM samples per period */
+enum class SamplePreference : std::uint8_t {
+	Resolution,		/* Many samples for a fine waveform */
+	Latency			/* Few samples for a short SRAM upload */
+};
+
+
+/* How the Si5351 reaches a new input frequency */
+enum class ClockPlanning : std::uint8_t {
+	Flexible,		/* PLL and multisynth are chosen freely, a change of the PLL needs a reset (glitch) */
+	FixedVco		/* The PLL stays at 900MHz and keeps locked, only multisynth and R divider change */
+};
+
+
+/* Settings of one Si5351 PLL and multisynth divider
+ * 	Output frequency = 25MHz * (pllMult + pllNum / pllDenom) / (msDiv + msNum / msDenom) / 2^rDiv */
+struct Si5351Settings {
+	std::uint32_t	pllMult;
+	std::uint32_t	pllNum;
+	std::uint32_t	pllDenom;
+	std::uint32_t	msDiv;		/* 4 selects the DIVBY4 mode */
+	std::uint32_t	msNum;
+	std::uint32_t	msDenom;
+	std::uint8_t	rDiv;		/* Exponent of the R divider */
+};
+
+
+/* Clock of the synthesizer for a signal and the resulting frequency */
+struct FrequencyPlan {
+	std::uint32_t	inputFrequency;		/* Nominal input frequency of the synthesizer */
+	std::uint32_t	clocksPerPeriod;	/* Clock cycles per signal period (the number of SRAM samples for SRAM patterns,
+										 * rounded down for sine signals at the maximum input frequency) */
+	Si5351Settings	clock;
+	std::uint32_t	achievedFrequency;	/* Signal frequency actually generated, rounded to Hz */
+	std::int32_t	frequencyError;		/* Achieved minus requested frequency in mHz */
+};
+
+
+/* Class FrequencyPlanner
+ * 	Chooses the input frequency of the synthesizer together with the Si5351 settings to create it.
+ *
+ * 	The input frequency is always an integer multiple of the signal frequency, so the number of
+ * 	samples (or of clock cycles for sine and the sawtooth generator) per period is exact. The
+ * 	remaining error comes from the 20-bit fractions of the Si5351 and from the tuning word of the DDS.
+ *
+ * 	Only a bounded number of candidates is evaluated: a window of sample counts around the preferred
+ * 	one (plus the counts giving exact tuning words for sine, or all steps of the sawtooth generator),
+ * 	and the 13 integer PLL multipliers for each of them. Candidates with an error below
+ * 	acceptableError are treated as equal, among them the one closest to the preferred count wins.
+ *
+ * 	Sine signals run at the maximum input frequency, as long as the tuning word reaches the frequency
+ * 	within sineFixedClockTolerance. A change of their frequency then only needs a new tuning word.
+ *
+ * 	With ClockPlanning::FixedVco only the 900MHz PLL setting is used, which limits the input
+ * 	frequency to 3907Hz..112.5MHz. Signals that can't be created this way fall back to flexible planning.
+ */
+class FrequencyPlanner
+{
+public:
+
+	/* Synthesizer input frequency range */
+	static constexpr std::uint32_t maxInputFrequency = 180000000;
+	static constexpr std::uint32_t minInputFrequency = 2605;	/* 600MHz / 1800 / 128 */
+
+	/* Preferred number of SRAM samples. Signals up to latencyThresholdFrequency prefer the finer resolution:
+	 * Their period is at least as long as the upload of the additional samples. Faster signals prefer a quarter
+	 * of the SRAM, so several patterns stay resident */
+	static constexpr std::uint32_t lowFrequencyNumOfSamples = 2048;
+	static constexpr std::uint32_t resolutionNumOfSamples = 1024;
+	static constexpr std::uint32_t latencyNumOfSamples = 256;
+	static constexpr std::uint32_t latencyThresholdFrequency = 1000;
+	static constexpr std::uint32_t maxNumOfSamples = 4096;
+
+	/* Preferred number of clock cycles per period for sine signals. A power of two gives an exact tuning word */
+	static constexpr std::uint32_t sineClocksPerPeriod = 1024;
+
+	/* Relative errors (in ppb) below this are negligible compared to the crystal */
+	static constexpr std::int64_t acceptableError = 100;
+
+	/* Input frequency range with a fixed VCO */
+	static constexpr std::uint32_t maxFixedVcoInputFrequency = 112500000;	/* 900MHz / 8 */
+	static constexpr std::uint32_t minFixedVcoInputFrequency = 3907;		/* 900MHz / 1800 / 128 */
+
+	/* Relative error (in ppb) up to which sine signals run at the maximum input frequency */
+	static constexpr std::int64_t sineFixedClockTolerance = 50000;
+
+	static auto plan(ChannelSettings const& settings, SamplePreference const preference,
+			ClockPlanning const planning = ClockPlanning::Flexible) -> FrequencyPlan;
+
+	/* Plan for a sine signal at the maximum input frequency of the planning mode.
+	 * Returns false, if the tuning word can't reach the frequency within sineFixedClockTolerance */
+	static auto fixedClockSinePlan(std::uint32_t const frequency, ClockPlanning const planning, FrequencyPlan& plan) -> bool;
+
+	/* Plan for the given input frequency without a signal, e.g. for chirps. The achieved frequency is the one
+	 * of the input. Returns false, if the Si5351 can't create it */
+	static auto inputFrequencyPlan(std::uint32_t const inputFrequency, ClockPlanning const planning, FrequencyPlan& plan) -> bool;
+
+private:
+
+	static constexpr std::uint32_t crystalFrequency = 25000000;
+	static constexpr std::uint32_t minPllMult = 24;		/* 600MHz VCO */
+	static constexpr std::uint32_t maxPllMult = 36;		/* 900MHz VCO */
+	static constexpr std::uint32_t fixedPllMult = 36;
+	static constexpr std::uint32_t minMsDiv = 8;
+	static constexpr std::uint32_t maxMsDiv = 1800;
+	static constexpr std::uint32_t maxRDiv = 7;
+	static constexpr std::uint32_t maxDenominator = 1048575;
+	static constexpr std::uint32_t tuningWordRange = 1UL<<24;
+
+	/* Number of sample counts evaluated on each side of the preferred one */
+	static constexpr std::uint32_t searchWindow = 4;
+
+	/* Best approximation num / denom of the fraction p / q (p < q) with denom <= maxDenominator */
+	static auto approximate(std::uint64_t const p, std::uint64_t const q, std::uint32_t& num, std::uint32_t& denom) -> void;
+
+	/* Si5351 settings for the given output frequency. Returns false, if it can't be created.
+	 * error receives the relative error of the output frequency in ppb */
+	static auto configureClock(std::uint32_t const frequency, ClockPlanning const planning, Si5351Settings& clock,
+			std::int64_t& error) -> bool;
+
+	/* Evaluate the given number of clock cycles per period and keep it, if it beats the best plan so far */
+	static auto evaluate(ChannelSettings const& settings, std::uint32_t const clocksPerPeriod, std::uint32_t const preferred,
+			ClockPlanning const planning, FrequencyPlan& best, std::int64_t& bestError, bool& found) -> void;
+
+	/* Fill in the achieved frequency from the relative error (in ppb) */
+	static auto applyError(FrequencyPlan& plan, std::uint32_t const frequency, std::int64_t const error) -> void;
+
+	/* Evaluate all candidates for the signal. Returns false, if none of them can be created */
+	static auto search(ChannelSettings const& settings, SamplePreference const preference, ClockPlanning const planning,
+			FrequencyPlan& best, std::int64_t& bestError) -> bool;
+};
+
+
+inline auto FrequencyPlanner::
+approximate(std::uint64_t p, std::uint64_t q, std::uint32_t& num, std::uint32_t& denom) -> void
+{
+	std::uint64_t const fracP = p;
+	std::uint64_t const fracQ = q;
+
+	/* Continued fraction expansion: h0/k0 and h1/k1 are the last two convergents */
+	std::uint64_t h0 = 0, k0 = 1, h1 = 1, k1 = 0;
+
+	while (q != 0) {
+		std::uint64_t const a = p / q;
+		std::uint64_t const k2 = k0 + (a * k1);
+
+		if (k2 > maxDenominator) {
+			/* Denominator limit reached: The best semiconvergent competes with the last convergent */
+			std::uint64_t const t = (maxDenominator - k0) / k1;
+			std::uint64_t const hs = h0 + (t * h1);
+			std::uint64_t const ks = k0 + (t * k1);
+
+			/* |p/q - h/k| * q = |p*k - h*q| / k */
+			std::uint64_t const errConvergent = (fracP * k1 > h1 * fracQ) ? (fracP * k1 - h1 * fracQ) : (h1 * fracQ - fracP * k1);
+			std::uint64_t const errSemi = (fracP * ks > hs * fracQ) ? (fracP * ks - hs * fracQ) : (hs * fracQ - fracP * ks);
+
+			if ((t > 0) && (errSemi * k1 < errConvergent * ks)) {
+				h1 = hs;
+				k1 = ks;
+			}
+			break;
+		}
+
+		std::uint64_t const h2 = h0 + (a * h1);
+		h0 = h1;
+		k0 = k1;
+		h1 = h2;
+		k1 = k2;
+
+		std::uint64_t const r = p - (a * q);
+		p = q;
+		q = r;
+	}
+
+	num = static_cast<std::uint32_t>(h1);
+	denom = static_cast<std::uint32_t>(k1);
+}
+
+
+inline auto FrequencyPlanner::
+configureClock(std::uint32_t const frequency, ClockPlanning const planning, Si5351Settings& clock,
+		std::int64_t& error) -> bool
+{
+	bool const fixedVco = (planning == ClockPlanning::FixedVco);
+
+	if ((frequency < (fixedVco ? minFixedVcoInputFrequency : minInputFrequency))
+			|| (frequency > (fixedVco ? maxFixedVcoInputFrequency : maxInputFrequency))) {
+		return false;
+	}
+
+	if (not fixedVco && (frequency >= (minPllMult * crystalFrequency) / 4)) {
+		/* DIVBY4 mode: Integer multisynth, the fractional PLL sets the frequency */
+		std::uint64_t const p = 4ULL * frequency;
+		std::uint64_t const q = crystalFrequency;
+
+		clock.pllMult = static_cast<std::uint32_t>(p / q);
+		approximate(p % q, q, clock.pllNum, clock.pllDenom);
+		if (clock.pllNum == clock.pllDenom) {
+			clock.pllMult++;
+			clock.pllNum = 0;
+			clock.pllDenom = 1;
+		}
+
+		clock.msDiv = 4;
+		clock.msNum = 0;
+		clock.msDenom = 1;
+		clock.rDiv = 0;
+
+		/* The output frequency follows the PLL */
+		std::int64_t const deviation = static_cast<std::int64_t>(clock.pllNum * q) - static_cast<std::int64_t>((p % q) * clock.pllDenom);
+		error = (deviation * 1000000000LL) / static_cast<std::int64_t>(clock.pllDenom * p);
+
+		return true;
+	}
+
+	std::uint32_t const firstPllMult = fixedVco ? fixedPllMult : minPllMult;
+	std::uint32_t const lastPllMult = fixedVco ? fixedPllMult : maxPllMult;
+
+	/* Smallest R divider that keeps the multisynth divider in range */
+	std::uint8_t rDiv = 0;
+	while ((rDiv < maxRDiv) && ((static_cast<std::uint64_t>(frequency) << rDiv) * maxMsDiv < firstPllMult * crystalFrequency)) {
+		rDiv++;
+	}
+
+	bool found = false;
+
+	/* Integer PLL, the fractional multisynth sets the frequency */
+	for (std::uint32_t pllMult = firstPllMult; pllMult <= lastPllMult; pllMult++) {
+		std::uint64_t const p = static_cast<std::uint64_t>(pllMult) * crystalFrequency;
+		std::uint64_t const q = static_cast<std::uint64_t>(frequency) << rDiv;
+
+		Si5351Settings candidate = {pllMult, 0, 1, static_cast<std::uint32_t>(p / q), 0, 1, rDiv};
+		if ((candidate.msDiv < minMsDiv) || (candidate.msDiv >= maxMsDiv)) {
+			continue;
+		}
+
+		approximate(p % q, q, candidate.msNum, candidate.msDenom);
+		if (candidate.msNum == candidate.msDenom) {
+			candidate.msDiv++;
+			candidate.msNum = 0;
+			candidate.msDenom = 1;
+		}
+
+		/* The output frequency is inverse to the multisynth divider */
+		std::int64_t const deviation = static_cast<std::int64_t>((p % q) * candidate.msDenom) - static_cast<std::int64_t>(candidate.msNum * q);
+		std::int64_t const candidateError = (deviation * 1000000000LL) / static_cast<std::int64_t>(candidate.msDenom * p);
+
+		/* Prefer the smaller error, then an integer divider (less jitter) */
+		std::int64_t const magnitude = (candidateError < 0) ? -candidateError : candidateError;
+		std::int64_t const bestMagnitude = (error < 0) ? -error : error;
+		if (not found || (magnitude < bestMagnitude)
+				|| ((magnitude == bestMagnitude) && (candidate.msNum == 0) && (clock.msNum != 0))) {
+			clock = candidate;
+			error = candidateError;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
+
+inline auto FrequencyPlanner::
+evaluate(ChannelSettings const& settings, std::uint32_t const clocksPerPeriod, std::uint32_t const preferred,
+		ClockPlanning const planning, FrequencyPlan& best, std::int64_t& bestError, bool& found) -> void
+{
+	std::uint64_t const inputFrequency = static_cast<std::uint64_t>(settings.frequency_) * clocksPerPeriod;
+	if (inputFrequency > maxInputFrequency) {
+		return;
+	}
+
+	Si5351Settings clock;
+	std::int64_t error = 0;
+	if (not configureClock(static_cast<std::uint32_t>(inputFrequency), planning, clock, error)) {
+		return;
+	}
+
+	if (settings.form_ == Waveform::Sine) {
+		/* The DDS rounds the tuning word to an integer */
+		std::uint64_t const tuningWord = (tuningWordRange + (clocksPerPeriod / 2)) / clocksPerPeriod;
+		std::int64_t const deviation = static_cast<std::int64_t>(tuningWord * clocksPerPeriod) - static_cast<std::int64_t>(tuningWordRange);
+		error += (deviation * 1000000000LL) / tuningWordRange;
+	}
+
+	std::int64_t const magnitude = (error < 0) ? -error : error;
+	std::int64_t const bestMagnitude = (bestError < 0) ? -bestError : bestError;
+	bool const acceptable = magnitude <= acceptableError;
+	bool const bestAcceptable = bestMagnitude <= acceptableError;
+
+	auto distance = [preferred](std::uint32_t const count) {
+		return (count > preferred) ? (count - preferred) : (preferred - count);
+	};
+
+	bool better = not found;
+	if (acceptable && bestAcceptable) {
+		better |= distance(clocksPerPeriod) < distance(best.clocksPerPeriod);
+	}
+	else {
+		better |= magnitude < bestMagnitude;
+	}
+
+	if (better) {
+		best.inputFrequency = static_cast<std::uint32_t>(inputFrequency);
+		best.clocksPerPeriod = clocksPerPeriod;
+		best.clock = clock;
+		bestError = error;
+		found = true;
+	}
+}
+
+
+inline auto FrequencyPlanner::
+search(ChannelSettings const& settings, SamplePreference const preference, ClockPlanning const planning,
+		FrequencyPlan& best, std::int64_t& bestError) -> bool
+{
+	bool found = false;
+
+	std::uint32_t const frequency = settings.frequency_;
+	bool const fixedVco = (planning == ClockPlanning::FixedVco);
+	std::uint32_t const lowestInputFrequency = fixedVco ? minFixedVcoInputFrequency : minInputFrequency;
+	std::uint32_t const highestInputFrequency = fixedVco ? maxFixedVcoInputFrequency : maxInputFrequency;
+
+	/* Range of clock cycles per period that give a valid input frequency */
+	std::uint32_t minClocks = (lowestInputFrequency + frequency - 1) / frequency;
+	std::uint32_t maxClocks = highestInputFrequency / frequency;
+	if (minClocks < 2) {
+		minClocks = 2;
+	}
+
+	std::uint32_t const sawCycles = sawCyclesPerStep(settings);
+	if ((sawCycles != 0) && (sawCycles <= maxClocks)) {
+		/* Sawtooth generator: Every step is a candidate, the finest steps in time are preferred */
+		for (std::uint32_t step = 1; step <= sawMaxStep; step++) {
+			evaluate(settings, sawCycles * step, maxClocks, planning, best, bestError, found);
+		}
+	}
+
+	if (not found) {
+		std::uint32_t preferred = sineClocksPerPeriod;
+
+		if (settings.form_ != Waveform::Sine) {
+			if (preference == SamplePreference::Latency) {
+				preferred = latencyNumOfSamples;
+			}
+			else {
+				preferred = (frequency <= latencyThresholdFrequency) ? lowFrequencyNumOfSamples : resolutionNumOfSamples;
+			}
+
+			if (maxClocks > maxNumOfSamples) {
+				maxClocks = maxNumOfSamples;
+			}
+		}
+		else {
+			/* Powers of two give exact tuning words */
+			for (std::uint32_t clocks = 2; clocks <= maxClocks; clocks <<= 1) {
+				if (clocks >= minClocks) {
+					evaluate(settings, clocks, preferred, planning, best, bestError, found);
+				}
+				if (clocks > (tuningWordRange >> 1)) {
+					break;
+				}
+			}
+		}
+
+		/* Window around the preferred count, moved into the valid range */
+		std::uint32_t center = preferred;
+		if (center > maxClocks) {
+			center = maxClocks;
+		}
+		if (center < minClocks + searchWindow) {
+			center = minClocks + searchWindow;
+		}
+
+		for (std::uint32_t clocks = center - searchWindow; (clocks <= center + searchWindow) && (clocks <= maxClocks); clocks++) {
+			evaluate(settings, clocks, preferred, planning, best, bestError, found);
+		}
+	}
+
+	return found;
+}
+
+
+inline auto FrequencyPlanner::
+plan(ChannelSettings const& settings, SamplePreference const preference, ClockPlanning const planning) -> FrequencyPlan
+{
+	FrequencyPlan best = {};
+	std::int64_t bestError = 0;
+
+	ChannelSettings signal = settings;
+	if (signal.frequency_ == 0) {
+		signal.frequency_ = 1;
+	}
+	std::uint32_t const frequency = signal.frequency_;
+
+	if ((signal.form_ == Waveform::Sine) && fixedClockSinePlan(frequency, planning, best)) {
+		return best;
+	}
+
+	bool found = search(signal, preference, planning, best, bestError);
+
+	if (not found && (planning == ClockPlanning::FixedVco)) {
+		/* Out of reach for the fixed VCO: Change the PLL after all */
+		found = search(signal, preference, ClockPlanning::Flexible, best, bestError);
+	}
+
+	if (not found) {
+		/* Only for frequencies outside the supported range: Run the synthesizer at its maximum clock */
+		best.inputFrequency = maxInputFrequency;
+		best.clocksPerPeriod = maxInputFrequency / frequency;
+		best.clock = {28, 4, 5, 4, 0, 1, 0};
+		best.achievedFrequency = (best.clocksPerPeriod > 0) ? (maxInputFrequency / best.clocksPerPeriod) : maxInputFrequency;
+		best.frequencyError = (static_cast<std::int32_t>(best.achievedFrequency) - static_cast<std::int32_t>(frequency)) * 1000;
+		return best;
+	}
+
+	applyError(best, frequency, bestError);
+
+	return best;
+}
+
+
+inline auto FrequencyPlanner::
+fixedClockSinePlan(std::uint32_t const frequency, ClockPlanning const planning, FrequencyPlan& plan) -> bool
+{
+	std::uint32_t const inputFrequency = (planning == ClockPlanning::FixedVco) ? maxFixedVcoInputFrequency : maxInputFrequency;
+
+	/* At least two clock cycles per period */
+	if ((frequency == 0) || (inputFrequency / frequency < 2)) {
+		return false;
+	}
+
+	Si5351Settings clock = {};
+	std::int64_t error = 0;
+	if (not configureClock(inputFrequency, planning, clock, error)) {
+		return false;
+	}
+
+	/* The DDS rounds the tuning word to an integer */
+	std::uint64_t const scaledFrequency = static_cast<std::uint64_t>(frequency) << 24;
+	std::uint64_t const tuningWord = (scaledFrequency + (inputFrequency / 2)) / inputFrequency;
+	std::int64_t const deviation = static_cast<std::int64_t>(tuningWord * inputFrequency) - static_cast<std::int64_t>(scaledFrequency);
+	error += (deviation * 1000000000LL) / static_cast<std::int64_t>(scaledFrequency);
+
+	if ((error > sineFixedClockTolerance) || (error < -sineFixedClockTolerance)) {
+		return false;
+	}
+
+	plan.inputFrequency = inputFrequency;
+	plan.clocksPerPeriod = inputFrequency / frequency;
+	plan.clock = clock;
+	applyError(plan, frequency, error);
+
+	return true;
+}
+
+
+inline auto FrequencyPlanner::
+inputFrequencyPlan(std::uint32_t const inputFrequency, ClockPlanning const planning, FrequencyPlan& plan) -> bool
+{
+	Si5351Settings clock = {};
+	std::int64_t error = 0;
+	if (not configureClock(inputFrequency, planning, clock, error)) {
+		return false;
+	}
+
+	plan.inputFrequency = inputFrequency;
+	plan.clocksPerPeriod = 0;
+	plan.clock = clock;
+	applyError(plan, inputFrequency, error);
+
+	return true;
+}
+
+
+inline auto FrequencyPlanner::
+applyError(FrequencyPlan& plan, std::uint32_t const frequency, std::int64_t const error) -> void
+{
+	/* Error in mHz, from the relative error in ppb */
+	std::int64_t const errorMilliHertz = (static_cast<std::int64_t>(frequency) * error) / 1000000LL;
+	plan.frequencyError = static_cast<std::int32_t>(errorMilliHertz);
+	plan.achievedFrequency = static_cast<std::uint32_t>(((static_cast<std::int64_t>(frequency) * 1000) + errorMilliHertz + 500) / 1000);
+}
+
+
+} /* namespace SignalGeneration */
+
+#endif /* FREQUENCYPLANNER_H_ */
@@ -0,0 +1,304 @@
+#ifndef FREQUENCYSWEEP_H_
+#define FREQUENCYSWEEP_H_
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <array>
+
+#include "SignalGenerationCommon.h"
+
+
+namespace SignalGeneration {
+
+
+struct SweepSettings {
+	std::uint32_t	startFrequency;
+	std::uint32_t	stopFrequency;
+	SweepLaw		law;
+	std::uint32_t	sweepTime;		/* Time from start to stop frequency in ms */
+	bool			repeat;			/* Restart at the start frequency, otherwise stay at the stop frequency */
+};
+
+
+/* Class FrequencySweep
+ * 	Sweeps a sine signal by changing only the tuning word of the DDS. The SPI commands of all steps
+ * 	are calculated in advance, so the interrupt of the step timer only hands the next frame to the
+ * 	SPI driver. The event loop isn't involved while the sweep is running.
+ *
+ * 	Frames are not sent from the step table itself: Each step copies its frame into one of two send
+ * 	buffers, alternately. The frame of the last step may still be queued when the next sweep starts,
+ * 	the step table can be rewritten nevertheless. A send buffer is reused after two step intervals,
+ * 	far longer than the transfer of a frame.
+ *
+ * 	The sweep time is divided into at most maxNumOfSteps steps of at least minStepInterval. The input
+ * 	frequency of the DDS stays constant, so the frequency resolution is input frequency / 2^24.
+ *
+ * 	The time between the step interrupts is measured with the cycle counter. Its largest deviation
+ * 	from the nominal step interval is the step jitter.
+ *
+ * 	@template TStepTimer - Periodic timer calling its handler from the interrupt, may be shared with
+ * 			the shift keying (the handler is set with each start)
+ * 	@template TDeviceCore - Provides the cycle counter to measure the step jitter
+ */
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+class FrequencySweep
+{
+public:
+
+	/* Limits of the step table. Each step sends 12 bytes to the DDS, which takes about 50µs at 2.5MHz.
+	 * With the 40MHz bus profile of the DDS the interval is kept as a safe upper bound */
+	static constexpr std::uint32_t maxNumOfSteps = 1024;
+	static constexpr std::uint32_t minStepInterval = 100;	/* µs */
+	static constexpr std::uint32_t maxStepInterval = TStepTimer::maxPeriod;
+	static constexpr std::uint32_t maxSweepTime = ((maxNumOfSteps - 1) * maxStepInterval) / 1000;	/* ms */
+
+	/* Constructor */
+	FrequencySweep(TDirectDigitalSynthesizer const& synthesizer, TStepTimer const& stepTimer);
+
+	/* Destructor */
+	~FrequencySweep();
+
+	/* Calculate the steps and start the sweep. The DDS has to generate the start frequency already.
+	 * Returns false, if the sweep can't be created with the given input frequency */
+	auto start(SweepSettings const& settings, std::uint32_t const inputFrequency) const -> bool;
+
+	/* Stop the sweep at the current step */
+	auto stop(void) const -> void;
+
+	/* True until the stop frequency is reached (never for a repeated sweep) or stop() is called */
+	auto isRunning(void) const -> bool { return running_; }
+
+	auto numOfSteps(void) const -> std::uint32_t { return numOfSteps_; }
+
+	/* Time between two steps in µs */
+	auto stepInterval(void) const -> std::uint32_t { return stepInterval_; }
+
+	/* Largest deviation of the time between two steps from the step interval in ns, measured since the start */
+	auto maxStepJitter(void) const -> std::uint32_t;
+
+private:
+
+	/* Fill the step table. Linear sweeps interpolate the tuning word exactly, logarithmic ones multiply it
+	 * with a constant ratio (the last step is exactly the stop frequency) */
+	auto calculateSteps(SweepSettings const& settings, std::uint32_t const startWord, std::uint32_t const stopWord) const -> void;
+
+	/* Handler of the step timer, runs in the interrupt */
+	auto step(void) const -> void;
+
+	mutable std::uint8_t* stepTable_;
+	mutable std::array<std::array<std::uint8_t, TDirectDigitalSynthesizer::tuningWordFrameSize>, 2> sendBuffers_;
+	mutable std::uint8_t nextSendBuffer_;
+	mutable std::uint32_t numOfSteps_;
+	mutable std::uint32_t stepInterval_;
+	mutable volatile std::uint32_t nextStep_;
+	mutable volatile bool repeat_;
+	mutable volatile bool running_;
+
+	/* Jitter measurement in cycles of the core clock */
+	mutable std::uint32_t nominalCycles_;
+	mutable volatile std::uint32_t lastStepCycle_;
+	mutable volatile std::uint32_t maxDeviationCycles_;
+	mutable volatile bool firstStep_;
+
+	TDirectDigitalSynthesizer const& synthesizer_;
+	TStepTimer const& stepTimer_;
+};
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+constexpr std::uint32_t FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::maxNumOfSteps;
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+constexpr std::uint32_t FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::minStepInterval;
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+constexpr std::uint32_t FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::maxStepInterval;
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+constexpr std::uint32_t FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::maxSweepTime;
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+FrequencySweep(TDirectDigitalSynthesizer const& synthesizer, TStepTimer const& stepTimer) :
+	stepTable_(nullptr),
+	sendBuffers_(),
+	nextSendBuffer_(0),
+	numOfSteps_(0),
+	stepInterval_(0),
+	nextStep_(0),
+	repeat_(false),
+	running_(false),
+	nominalCycles_(0),
+	lastStepCycle_(0),
+	maxDeviationCycles_(0),
+	firstStep_(true),
+	synthesizer_(synthesizer),
+	stepTimer_(stepTimer)
+{
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+~FrequencySweep()
+{
+	stop();
+
+	/* Free memory of the step table */
+	if (stepTable_) {
+		free(stepTable_);
+	}
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+auto FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+start(SweepSettings const& settings, std::uint32_t const inputFrequency) const -> bool
+{
+	stop();
+
+	/* Memory for the SPI commands of all steps, only taken when the first sweep starts and kept afterwards */
+	if (stepTable_ == nullptr) {
+		stepTable_ = reinterpret_cast<std::uint8_t*>(malloc(maxNumOfSteps * TDirectDigitalSynthesizer::tuningWordFrameSize));
+	}
+
+	if ((stepTable_ == nullptr) || (inputFrequency == 0) || (settings.sweepTime == 0)
+			|| (settings.sweepTime > maxSweepTime)) {
+		return false;
+	}
+
+	/* Both frequencies need a tuning word below the Nyquist frequency */
+	std::uint32_t const startWord = TDirectDigitalSynthesizer::calculateTuningWord(inputFrequency, settings.startFrequency);
+	std::uint32_t const stopWord = TDirectDigitalSynthesizer::calculateTuningWord(inputFrequency, settings.stopFrequency);
+	if ((startWord == 0) || (stopWord == 0) || (startWord >= (1UL<<23)) || (stopWord >= (1UL<<23))) {
+		return false;
+	}
+
+	/* As many steps as possible, but not faster than minStepInterval */
+	std::uint32_t const sweepTime = settings.sweepTime * 1000;
+	numOfSteps_ = sweepTime / minStepInterval;
+	if (numOfSteps_ > maxNumOfSteps) {
+		numOfSteps_ = maxNumOfSteps;
+	}
+	if (numOfSteps_ < 2) {
+		numOfSteps_ = 2;
+	}
+
+	/* The first step is played when the sweep starts, so the stop frequency is reached after the sweep time */
+	stepInterval_ = sweepTime / (numOfSteps_ - 1);
+
+	calculateSteps(settings, startWord, stopWord);
+
+	nextStep_ = 1;
+	repeat_ = settings.repeat;
+	nominalCycles_ = stepInterval_ * (TDeviceCore::systemCoreClock() / 1000000);
+	maxDeviationCycles_ = 0;
+	firstStep_ = true;
+	running_ = true;
+
+	stepTimer_.setCallbackHandler([this]() {
+		this->step();
+	});
+	stepTimer_.start(stepInterval_);
+
+	return true;
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+auto FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+stop(void) const -> void
+{
+	if (running_) {
+		stepTimer_.stop();
+		running_ = false;
+	}
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+auto FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+maxStepJitter(void) const -> std::uint32_t
+{
+	return (maxDeviationCycles_ * 1000) / (TDeviceCore::systemCoreClock() / 1000000);
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+auto FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+calculateSteps(SweepSettings const& settings, std::uint32_t const startWord, std::uint32_t const stopWord) const -> void
+{
+	std::uint32_t const lastStep = numOfSteps_ - 1;
+
+	/* Ratio between the tuning words of two steps */
+	double const ratio = std::pow(static_cast<double>(stopWord) / startWord, 1.0 / lastStep);
+	double logWord = startWord;
+
+	for (std::uint32_t i = 0; i < numOfSteps_; i++) {
+		std::uint32_t tuningWord = stopWord;
+
+		if (i < lastStep) {
+			if (settings.law == SweepLaw::Linear) {
+				/* Weighted mean of both tuning words, rounded */
+				tuningWord = static_cast<std::uint32_t>(((static_cast<std::uint64_t>(startWord) * (lastStep - i))
+						+ (static_cast<std::uint64_t>(stopWord) * i) + (lastStep / 2)) / lastStep);
+			}
+			else {
+				tuningWord = static_cast<std::uint32_t>(logWord + 0.5);
+				logWord *= ratio;
+			}
+		}
+
+		TDirectDigitalSynthesizer::createTuningWordFrame(tuningWord, stepTable_ + (i * TDirectDigitalSynthesizer::tuningWordFrameSize));
+	}
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer, typename TDeviceCore>
+auto FrequencySweep<TDirectDigitalSynthesizer, TStepTimer, TDeviceCore>::
+step(void) const -> void
+{
+	std::uint32_t const now = TDeviceCore::cycleCount();
+
+	/* Jitter of the step interrupts */
+	if (not firstStep_) {
+		std::uint32_t const interval = now - lastStepCycle_;
+		std::uint32_t const deviation = (interval > nominalCycles_) ? (interval - nominalCycles_) : (nominalCycles_ - interval);
+		if (deviation > maxDeviationCycles_) {
+			maxDeviationCycles_ = deviation;
+		}
+	}
+	lastStepCycle_ = now;
+	firstStep_ = false;
+
+	/* The buffer not used by the previous step, its frame may still be queued */
+	std::uint8_t* const frame = sendBuffers_[nextSendBuffer_].data();
+	nextSendBuffer_ ^= 1;
+
+	std::memcpy(frame, stepTable_ + (nextStep_ * TDirectDigitalSynthesizer::tuningWordFrameSize),
+			TDirectDigitalSynthesizer::tuningWordFrameSize);
+
+	/* A dropped step is counted by the synthesizer, the next one corrects the frequency */
+	synthesizer_.writeTuningWordFrame(frame);
+
+	if (++nextStep_ < numOfSteps_) {
+		return;
+	}
+
+	if (repeat_) {
+		nextStep_ = 0;
+	}
+	else {
+		/* Stop frequency reached */
+		stepTimer_.stop();
+		running_ = false;
+	}
+}
+
+
+} /* namespace SignalGeneration */
+
+#endif /* FREQUENCYSWEEP_H_ */
@@ -0,0 +1,612 @@
+#ifndef SAMPLEKERNELS_H_
+#define SAMPLEKERNELS_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+#if defined(__ARM_FEATURE_DSP)
+#include "stm32l476xx.h"	/* CMSIS core with the SIMD intrinsics of the Cortex-M4 */
+#endif
+
+
+namespace SignalGeneration {
+
+/* Integer sample kernels for the SRAM patterns of the DirectDigitalSynthesizer
+ *
+ * 	All kernels work with a Q16.16 accumulator holding the sample value in offset binary
+ * 	(0x0000 => -32768, 0xFFFF => 32767). Rounding is done by adding 0x8000 before taking the upper
+ * 	halfword, so no float or double math is needed at all. The kernels always produce two samples
+ * 	per call of nextPair(), packed into one 32-bit word (first sample in the lower halfword).
+ *
+ * 	Besides the CMSIS SIMD intrinsics, this file has no dependencies on the target, so it can
+ * 	be compiled on the host as well (the intrinsics are replaced by portable equivalents there).
+ */
+namespace SampleKernels {
+
+
+/* Full scale values of a sample */
+static constexpr std::int16_t sampleMax = std::numeric_limits<std::int16_t>::max();
+static constexpr std::int16_t sampleMin = std::numeric_limits<std::int16_t>::min();
+
+/* Maximum number of samples the SRAM of the DDS can store */
+static constexpr std::uint16_t maxNumOfSamples = 4096;
+
+
+namespace Simd {
+
+#if defined(__ARM_FEATURE_DSP)
+
+/* Lower halfword of low into the lower half, lower halfword of high into the upper half */
+inline auto packLow(std::uint32_t const low, std::uint32_t const high) -> std::uint32_t { return __PKHBT(low, high, 16); }
+
+/* Upper halfword of high into the upper half, upper halfword of low into the lower half */
+inline auto packHigh(std::uint32_t const high, std::uint32_t const low) -> std::uint32_t { return __PKHTB(high, low, 16); }
+
+/* Reverse the byte order in each halfword */
+inline auto byteSwap16(std::uint32_t const value) -> std::uint32_t { return __REV16(value); }
+
+#else
+
+inline auto packLow(std::uint32_t const low, std::uint32_t const high) -> std::uint32_t
+{
+	return (low & 0x0000FFFF) | (high<<16);
+}
+
+inline auto packHigh(std::uint32_t const high, std::uint32_t const low) -> std::uint32_t
+{
+	return (high & 0xFFFF0000) | (low>>16);
+}
+
+inline auto byteSwap16(std::uint32_t const value) -> std::uint32_t
+{
+	return ((value & 0x00FF00FF)<<8) | ((value & 0xFF00FF00)>>8);
+}
+
+#endif
+
+} /* namespace Simd */
+
+
+/* Number of samples to get the target frequency with the given sample clock (rounded) */
+inline auto numOfSamples(std::uint32_t const inputFreq, std::uint32_t const targetFreq) -> std::uint16_t
+{
+	std::uint32_t samples = (inputFreq + (targetFreq / 2)) / targetFreq;
+
+	if (samples < 2) {
+		samples = 2;
+	}
+	else if (samples > maxNumOfSamples) {
+		samples = maxNumOfSamples;
+	}
+
+	return static_cast<std::uint16_t>(samples);
+}
+
+
+/* Number of samples to shift the pattern to represent the given phase (-180° to 180°).
+ * Negative phases are mapped onto the equivalent positive shift. */
+inline auto shiftSamples(std::int32_t const phase, std::uint16_t const numOfSamples) -> std::uint16_t
+{
+	std::uint32_t positivePhase = (phase >= 0) ? phase : (360 + phase);
+
+	return static_cast<std::uint16_t>(((2 * positivePhase * numOfSamples) + 360) / 720);
+}
+
+
+/* Convert two Q16.16 accumulators (offset binary) into two packed, rounded int16 samples */
+inline auto roundPair(std::uint32_t const acc0, std::uint32_t const acc1) -> std::uint32_t
+{
+	return Simd::packHigh(acc1 + 0x8000, acc0 + 0x8000) ^ 0x80008000;
+}
+
+
+/* Convert one Q16.16 accumulator (offset binary) into a rounded int16 sample */
+inline auto roundSingle(std::uint32_t const acc) -> std::uint32_t
+{
+	return ((acc + 0x8000)>>16) ^ 0x8000;
+}
+
+
+/* Sawtooth (Saw_pos and Saw_neg)
+ * 	Straight line over the full scale within numOfSamples samples. A phase shift moves the start point,
+ * 	values beyond full scale wrap around like the int16 conversion of the former float implementation. */
+class Ramp
+{
+public:
+
+	Ramp(bool const falling, std::uint16_t const numOfSamples, std::int32_t const phase) :
+		acc_(0),
+		step_(0)
+	{
+		/* Q16.16 delta between two samples: 65535 / (numOfSamples - 1) */
+		std::uint32_t delta = ((65535ull<<16) + ((numOfSamples - 1) / 2)) / (numOfSamples - 1);
+
+		/* Start point: (phase / 360) * numOfSamples samples into the ramp */
+		std::int64_t shift = (static_cast<std::int64_t>(phase) * numOfSamples * delta) / 360;
+
+		if (falling) {
+			acc_ = (65535u<<16) - static_cast<std::uint32_t>(shift);
+			step_ = 0u - delta;
+		}
+		else {
+			acc_ = static_cast<std::uint32_t>(shift);
+			step_ = delta;
+		}
+	}
+
+	inline auto nextPair(void) -> std::uint32_t
+	{
+		std::uint32_t acc0 = acc_;
+		std::uint32_t acc1 = acc_ + step_;
+		acc_ = acc1 + step_;
+
+		return roundPair(acc0, acc1);
+	}
+
+	inline auto next(void) -> std::uint32_t
+	{
+		std::uint32_t acc = acc_;
+		acc_ += step_;
+
+		return roundSingle(acc);
+	}
+
+private:
+
+	std::uint32_t acc_;
+	std::uint32_t step_;
+};
+
+
+/* Triangle
+ * 	Rising and falling slope have (numOfSamples + 1) / 2 samples each. The phase shift is rounded
+ * 	to full samples. The accumulator is reset to the exact peak on each change of direction. */
+class Triangle
+{
+public:
+
+	Triangle(std::uint16_t const numOfSamples, std::int32_t const phase) :
+		acc_(0),
+		step_(0),
+		halfOfSamples_((numOfSamples + 1) / 2),
+		remainingSamples_(0),
+		rising_(true)
+	{
+		/* Q16.16 delta between two samples: 65535 / halfOfSamples */
+		step_ = ((65535ull<<16) + (halfOfSamples_ / 2)) / halfOfSamples_;
+
+		std::uint16_t shift = shiftSamples(phase, numOfSamples) % (2 * halfOfSamples_);
+
+		if (shift >= halfOfSamples_) {
+			shift -= halfOfSamples_;
+			acc_ = (65535u<<16) - (shift * step_);
+			rising_ = false;
+		}
+		else {
+			acc_ = shift * step_;
+		}
+
+		remainingSamples_ = halfOfSamples_ - shift;
+	}
+
+	inline auto nextPair(void) -> std::uint32_t
+	{
+		if (remainingSamples_ > 2) {
+			std::uint32_t acc0 = acc_;
+			std::uint32_t acc1 = rising_ ? (acc_ + step_) : (acc_ - step_);
+			acc_ = rising_ ? (acc1 + step_) : (acc1 - step_);
+			remainingSamples_ -= 2;
+
+			return roundPair(acc0, acc1);
+		}
+
+		/* The slope changes within this pair */
+		std::uint32_t first = next();
+		return Simd::packLow(first, next());
+	}
+
+	inline auto next(void) -> std::uint32_t
+	{
+		std::uint32_t sample = roundSingle(acc_);
+
+		if (--remainingSamples_ == 0) {
+			/* Change direction and start at the exact peak */
+			rising_ = not rising_;
+			remainingSamples_ = halfOfSamples_;
+			acc_ = rising_ ? 0 : (65535u<<16);
+		}
+		else {
+			acc_ = rising_ ? (acc_ + step_) : (acc_ - step_);
+		}
+
+		return sample;
+	}
+
+private:
+
+	std::uint32_t acc_;
+	std::uint32_t step_;
+	std::uint16_t halfOfSamples_;
+	std::uint16_t remainingSamples_;
+	bool rising_;
+};
+
+
+/* Rectangle with variable duty cycle
+ * 	The first round(numOfSamples * dutyCycle / 100) samples of the unshifted pattern are high,
+ * 	the phase shift rotates the pattern by full samples. */
+class Pwm
+{
+public:
+
+	Pwm(std::uint16_t const numOfSamples, std::int32_t const phase, std::uint32_t const dutyCycle) :
+		numOfSamples_(numOfSamples),
+		numOfHighSamples_(static_cast<std::uint16_t>(((2 * numOfSamples * dutyCycle) + 100) / 200)),
+		remainingSamples_(0),
+		high_(false)
+	{
+		if (numOfHighSamples_ > numOfSamples_) {
+			numOfHighSamples_ = numOfSamples_;
+		}
+
+		/* Position in the unshifted pattern of the first sample */
+		std::uint16_t position = (numOfSamples_ - (shiftSamples(phase, numOfSamples_) % numOfSamples_)) % numOfSamples_;
+
+		if (position < numOfHighSamples_) {
+			high_ = true;
+			remainingSamples_ = numOfHighSamples_ - position;
+		}
+		else {
+			high_ = false;
+			remainingSamples_ = numOfSamples_ - position;
+		}
+	}
+
+	inline auto nextPair(void) -> std::uint32_t
+	{
+		if (remainingSamples_ > 2) {
+			remainingSamples_ -= 2;
+
+			return high_ ? pairHigh : pairLow;
+		}
+
+		/* The level changes within this pair */
+		std::uint32_t first = next();
+		return Simd::packLow(first, next());
+	}
+
+	inline auto next(void) -> std::uint32_t
+	{
+		std::uint32_t sample = high_ ? singleHigh : singleLow;
+
+		if (--remainingSamples_ == 0) {
+			toggle();
+		}
+
+		return sample;
+	}
+
+private:
+
+	static constexpr std::uint32_t singleHigh = static_cast<std::uint16_t>(sampleMax);
+	static constexpr std::uint32_t singleLow = static_cast<std::uint16_t>(sampleMin);
+	static constexpr std::uint32_t pairHigh = singleHigh<<16 | singleHigh;
+	static constexpr std::uint32_t pairLow = singleLow<<16 | singleLow;
+
+	inline auto toggle(void) -> void
+	{
+		if (numOfHighSamples_ == 0) {
+			/* Always low */
+			high_ = false;
+			remainingSamples_ = numOfSamples_;
+		}
+		else if (numOfHighSamples_ == numOfSamples_) {
+			/* Always high */
+			high_ = true;
+			remainingSamples_ = numOfSamples_;
+		}
+		else {
+			high_ = not high_;
+			remainingSamples_ = high_ ? numOfHighSamples_ : (numOfSamples_ - numOfHighSamples_);
+		}
+	}
+
+	std::uint16_t numOfSamples_;
+	std::uint16_t numOfHighSamples_;
+	std::uint16_t remainingSamples_;
+	bool high_;
+};
+
+
+/* Resampler for arbitrary waveforms
+ * 	Resamples one period of equally spaced points to numOfSamples samples, the points are treated as periodic.
+ * 	Between the points, the samples are interpolated linear or cubic (Catmull-Rom). The position within the
+ * 	points is kept as index and 32-bit fraction, so there is no noticeable drift even for long patterns.
+ * 	Without points, the output is zero. */
+class Resampler
+{
+public:
+
+	Resampler(std::int16_t const* const points, std::uint16_t const numOfPoints, bool const cubic,
+			std::uint16_t const numOfSamples, std::int32_t const phase) :
+		points_(points),
+		numOfPoints_(numOfPoints),
+		index_(0),
+		fraction_(0),
+		stepIndex_(0),
+		stepFraction_(0),
+		cubic_(cubic)
+	{
+		if ((points_ == nullptr) || (numOfPoints_ == 0)) {
+			numOfPoints_ = 0;
+			return;
+		}
+
+		/* Distance between two samples in points (32.32 fixed point) */
+		std::uint64_t step = (static_cast<std::uint64_t>(numOfPoints_)<<32) / numOfSamples;
+		stepIndex_ = static_cast<std::uint32_t>(step>>32);
+		stepFraction_ = static_cast<std::uint32_t>(step);
+
+		/* Start point: (phase / 360) * numOfPoints points into the period */
+		std::uint32_t positivePhase = (phase >= 0) ? phase : (360 + phase);
+		std::uint64_t start = ((static_cast<std::uint64_t>(positivePhase) * numOfPoints_)<<32) / 360;
+		index_ = static_cast<std::uint32_t>(start>>32) % numOfPoints_;
+		fraction_ = static_cast<std::uint32_t>(start);
+	}
+
+	inline auto nextPair(void) -> std::uint32_t
+	{
+		std::uint32_t first = next();
+		return Simd::packLow(first, next());
+	}
+
+	inline auto next(void) -> std::uint32_t
+	{
+		if (numOfPoints_ == 0) {
+			return 0;
+		}
+
+		std::int32_t sample = cubic_ ? interpolateCubic() : interpolateLinear();
+
+		/* Move on to the position of the next sample */
+		fraction_ += stepFraction_;
+		index_ += stepIndex_ + ((fraction_ < stepFraction_) ? 1 : 0);
+		if (index_ >= numOfPoints_) {
+			index_ -= numOfPoints_;
+		}
+
+		return static_cast<std::uint16_t>(sample);
+	}
+
+private:
+
+	/* Point with the given index, indices outside of the period wrap around */
+	inline auto point(std::int32_t index) const -> std::int32_t
+	{
+		if (index < 0) {
+			index += numOfPoints_;
+		}
+		else if (index >= static_cast<std::int32_t>(numOfPoints_)) {
+			index -= numOfPoints_;
+		}
+
+		return points_[index];
+	}
+
+	inline auto interpolateLinear(void) const -> std::int32_t
+	{
+		std::int32_t p0 = point(index_);
+		std::int32_t p1 = point(index_ + 1);
+
+		/* Q16 position between p0 and p1 */
+		std::int64_t t = fraction_>>16;
+
+		return p0 + static_cast<std::int32_t>(((p1 - p0) * t + 0x8000)>>16);
+	}
+
+	inline auto interpolateCubic(void) const -> std::int32_t
+	{
+		std::int32_t pm = point(static_cast<std::int32_t>(index_) - 1);
+		std::int32_t p0 = point(index_);
+		std::int32_t p1 = point(index_ + 1);
+		std::int32_t p2 = point(index_ + 2);
+
+		/* Catmull-Rom: p0 + ((a * t + b) * t + c) * t / 2, evaluated with a Q16 position t */
+		std::int64_t t = fraction_>>16;
+		std::int64_t a = -pm + 3*p0 - 3*p1 + p2;
+		std::int64_t b = 2*pm - 5*p0 + 4*p1 - p2;
+		std::int64_t c = p1 - pm;
+
+		std::int64_t value = ((a * t)>>16) + b;
+		value = ((value * t)>>16) + c;
+		value = p0 + (((value * t) + 0x10000)>>17);
+
+		/* Cubic interpolation may overshoot the points */
+		if (value > sampleMax) {
+			value = sampleMax;
+		}
+		else if (value < sampleMin) {
+			value = sampleMin;
+		}
+
+		return static_cast<std::int32_t>(value);
+	}
+
+	std::int16_t const* points_;
+	std::uint32_t numOfPoints_;
+	std::uint32_t index_;
+	std::uint32_t fraction_;
+	std::uint32_t stepIndex_;
+	std::uint32_t stepFraction_;
+	bool cubic_;
+};
+
+
+/* Tuning words of a chirp
+ * 	The DDS takes the 12 upper bits of each SRAM word as part of its tuning word, the kernel creates them
+ * 	as unsigned values in these bits. Linear chirps add a constant step to a Q12.20 accumulator,
+ * 	exponential ones multiply it with a constant Q2.30 ratio (calculated by the caller). */
+class TuningWordRamp
+{
+public:
+
+	/* A ratio of zero selects the linear course from startWord to stopWord */
+	TuningWordRamp(std::uint16_t const startWord, std::uint16_t const stopWord, std::uint16_t const numOfSteps,
+			std::uint32_t const ratio) :
+		acc_(static_cast<std::uint32_t>(startWord)<<20),
+		step_(0),
+		ratio_(ratio)
+	{
+		if (numOfSteps > 1) {
+			std::int64_t const span = (static_cast<std::int64_t>(stopWord) - startWord) * (1LL<<20);
+			step_ = static_cast<std::int32_t>(span / (numOfSteps - 1));
+		}
+	}
+
+	inline auto nextPair(void) -> std::uint32_t
+	{
+		std::uint32_t first = next();
+		return Simd::packLow(first, next());
+	}
+
+	inline auto next(void) -> std::uint32_t
+	{
+		std::uint32_t word = ((acc_ + (1u<<19))>>20) & 0x0FFF;
+
+		if (ratio_ == 0) {
+			acc_ += static_cast<std::uint32_t>(step_);
+		}
+		else {
+			acc_ = static_cast<std::uint32_t>((static_cast<std::uint64_t>(acc_) * ratio_)>>30);
+		}
+
+		return word<<4;
+	}
+
+private:
+
+	std::uint32_t acc_;
+	std::int32_t step_;
+	std::uint32_t ratio_;
+};
+
+
+/* Write numOfSamples samples of the given kernel into dest in the SRAM burst format of the DDS:
+ * 	Each sample occupies 2 bytes (MSB first), the SRAM address is only sent once in front of all samples.
+ * 	dest has to be 2 byte aligned. Two samples are generated and written per iteration. */
+template <typename TKernel>
+inline auto writeSamples(TKernel& kernel, std::uint8_t* dest, std::size_t numOfSamples) -> void
+{
+	if ((reinterpret_cast<std::uintptr_t>(dest) & 0x02) && (numOfSamples > 0)) {
+		/* Single sample first to get word aligned */
+		*reinterpret_cast<std::uint16_t*>(dest) = static_cast<std::uint16_t>(Simd::byteSwap16(kernel.next()));
+		dest += 2;
+		numOfSamples--;
+	}
+
+	std::uint32_t* destPtr = reinterpret_cast<std::uint32_t*>(dest);
+
+	for (; numOfSamples >= 2; numOfSamples -= 2) {
+		*destPtr++ = Simd::byteSwap16(kernel.nextPair());
+	}
+
+	if (numOfSamples > 0) {
+		*reinterpret_cast<std::uint16_t*>(destPtr) = static_cast<std::uint16_t>(Simd::byteSwap16(kernel.next()));
+	}
+}
+
+
+/* Pattern
+ * 	One of the kernels above, selected at runtime. The state is kept between the calls of write(),
+ * 	so a pattern can be created in several chunks. After numOfSamples samples, the kernel starts
+ * 	over from its initial state, so a pattern written repeatedly is exactly periodic. */
+class Pattern
+{
+public:
+
+	Pattern() : Pattern(Pwm(2, 0, 0), 2) {}
+	Pattern(Ramp const& ramp, std::uint16_t const numOfSamples) : Pattern(Type::Ramp, Kernel(ramp), numOfSamples) {}
+	Pattern(Triangle const& triangle, std::uint16_t const numOfSamples) : Pattern(Type::Triangle, Kernel(triangle), numOfSamples) {}
+	Pattern(Pwm const& pwm, std::uint16_t const numOfSamples) : Pattern(Type::Pwm, Kernel(pwm), numOfSamples) {}
+	Pattern(Resampler const& resampler, std::uint16_t const numOfSamples) : Pattern(Type::Resampler, Kernel(resampler), numOfSamples) {}
+	Pattern(TuningWordRamp const& ramp, std::uint16_t const numOfSamples) : Pattern(Type::TuningWordRamp, Kernel(ramp), numOfSamples) {}
+
+	inline auto write(std::uint8_t* dest, std::size_t numOfSamples) -> void
+	{
+		while (numOfSamples > 0) {
+			if (position_ == numOfSamples_) {
+				/* Start the next period */
+				current_ = initial_;
+				position_ = 0;
+			}
+
+			std::size_t count = numOfSamples_ - position_;
+			if (count > numOfSamples) {
+				count = numOfSamples;
+			}
+
+			switch (type_) {
+			case Type::Ramp:
+				writeSamples(current_.ramp, dest, count);
+				break;
+			case Type::Triangle:
+				writeSamples(current_.triangle, dest, count);
+				break;
+			case Type::Pwm:
+				writeSamples(current_.pwm, dest, count);
+				break;
+			case Type::Resampler:
+				writeSamples(current_.resampler, dest, count);
+				break;
+			case Type::TuningWordRamp:
+				writeSamples(current_.tuningWordRamp, dest, count);
+				break;
+			}
+
+			dest += 2 * count;
+			numOfSamples -= count;
+			position_ += count;
+		}
+	}
+
+private:
+
+	enum class Type : std::uint8_t {Ramp, Triangle, Pwm, Resampler, TuningWordRamp};
+
+	union Kernel {
+		Ramp ramp;
+		Triangle triangle;
+		Pwm pwm;
+		Resampler resampler;
+		TuningWordRamp tuningWordRamp;
+
+		explicit Kernel(Ramp const& r) : ramp(r) {}
+		explicit Kernel(Triangle const& t) : triangle(t) {}
+		explicit Kernel(Pwm const& p) : pwm(p) {}
+		explicit Kernel(Resampler const& r) : resampler(r) {}
+		explicit Kernel(TuningWordRamp const& t) : tuningWordRamp(t) {}
+	};
+
+	Pattern(Type const type, Kernel const& kernel, std::uint16_t const numOfSamples) :
+		type_(type),
+		numOfSamples_(numOfSamples),
+		position_(0),
+		initial_(kernel),
+		current_(kernel)
+	{
+	}
+
+	Type type_;
+	std::uint16_t numOfSamples_;
+	std::uint16_t position_;
+	Kernel initial_;
+	Kernel current_;
+};
+
+
+} /* namespace SampleKernels */
+
+} /* namespace SignalGeneration */
+
+#endif /* SAMPLEKERNELS_H_ */
@@ -0,0 +1,99 @@
+#ifndef SETTINGSDIFF_H_
+#define SETTINGSDIFF_H_
+
+#include <cstdint>
+#include <array>
+
+#include "SignalGenerationCommon.h"
+
+
+namespace SignalGeneration {
+
+
+/* Cheapest hardware path a change of the channel settings took */
+enum class ChangePath : std::uint8_t {
+	DacOnly,			/* Amplitude or offset: Reference voltages of the DAC */
+	DdsRegisters,		/* Tuning word, phase word or sawtooth generator: Only registers of the DDS */
+	SramPattern,		/* Pattern in the SRAM of the DDS created (or taken from a slot) */
+	ClockReplan,		/* New input frequency of the DDS from the Si5351 */
+
+	NumOfPaths
+};
+
+
+/* Class SettingsDiff
+ * 	Compares the settings last applied to the hardware with new ones and tells which stages have to run.
+ * 	After the stages ran, the path taken is counted, so the mix of changes can be read out in production.
+ */
+class SettingsDiff
+{
+public:
+
+	/* Hardware stages of a change, combined as flags */
+	enum Stage : std::uint8_t {
+		ClockStage = 0x01,			/* Plan and set the input frequency */
+		SynthesizerStage = 0x02,	/* Registers and SRAM pattern of the DDS */
+		AmplitudeStage = 0x04,
+		OffsetStage = 0x08
+	};
+
+	SettingsDiff() : counts_() {}
+
+	/* Stages affected by the change from previous to next */
+	static auto stages(ChannelSettings const& previous, ChannelSettings const& next) -> std::uint8_t
+	{
+		std::uint8_t result = 0;
+
+		/* The plan depends on the frequency, on sine or samples and on the sawtooth generator */
+		if ((previous.frequency_ != next.frequency_)
+				|| ((previous.form_ == Waveform::Sine) != (next.form_ == Waveform::Sine))
+				|| (sawCyclesPerStep(previous) != sawCyclesPerStep(next))) {
+			result |= ClockStage;
+		}
+
+		if ((previous.form_ != next.form_) || (previous.frequency_ != next.frequency_) || (previous.phase_ != next.phase_)
+				|| ((previous.dutyCycle_ != next.dutyCycle_) && (next.form_ == Waveform::Rect))) {
+			result |= SynthesizerStage;
+		}
+
+		if (previous.amplitude_ != next.amplitude_) {
+			result |= AmplitudeStage;
+		}
+
+		if (previous.offset_ != next.offset_) {
+			result |= OffsetStage;
+		}
+
+		return result;
+	}
+
+	/* Count the path taken by the stages that ran. The clock only counts, if the input frequency changed */
+	auto record(std::uint8_t const stagesRun, bool const inputFrequencyChanged, bool const sramPattern) -> ChangePath
+	{
+		ChangePath path = ChangePath::DacOnly;
+
+		if (inputFrequencyChanged) {
+			path = ChangePath::ClockReplan;
+		}
+		else if (stagesRun & (ClockStage | SynthesizerStage)) {
+			path = sramPattern ? ChangePath::SramPattern : ChangePath::DdsRegisters;
+		}
+
+		counts_[static_cast<std::size_t>(path)]++;
+		return path;
+	}
+
+	/* Number of changes that took the given path */
+	auto count(ChangePath const path) const -> std::uint32_t { return counts_[static_cast<std::size_t>(path)]; }
+
+	auto resetCounts(void) -> void { counts_.fill(0); }
+
+private:
+
+	std::array<std::uint32_t, static_cast<std::size_t>(ChangePath::NumOfPaths)> counts_;
+};
+
+
+} /* namespace SignalGeneration */
+
+#endif /* SETTINGSDIFF_H_ */
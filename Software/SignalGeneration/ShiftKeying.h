@@ -0,0 +1,231 @@
+#ifndef SHIFTKEYING_H_
+#define SHIFTKEYING_H_
+
+#include <cstdint>
+#include <array>
+
+#include "SignalGenerationCommon.h"
+
+
+namespace SignalGeneration {
+
+
+/* Class ShiftKeying
+ * 	Hops a sine signal between the frequencies and phases of up to four symbols (FSK, PSK or both).
+ * 	The SPI commands of each symbol are created once at the start, only the registers that differ
+ * 	between the symbols are part of them. The interrupt of the symbol timer hands the frame of the
+ * 	next symbol to the SPI driver, nothing is calculated or allocated per symbol.
+ *
+ * 	The fastest symbol rate depends on the number of registers per frame: Each register and the final
+ * 	RAMUPDATE take one SPI command, the time of the frame is estimated from the bus profile of the DDS.
+ * 	Frames are sent in place, so the first symbol is kept in a member as well. If the SPI driver drops
+ * 	a frame, the stream stops at the last symbol sent and failed() reports it.
+ *
+ * 	@template TStepTimer - Periodic timer calling its handler from the interrupt, may be shared with
+ * 			the sweep (the handler is set with each start)
+ */
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+class ShiftKeying
+{
+public:
+
+	/* Constructor */
+	ShiftKeying(TDirectDigitalSynthesizer const& synthesizer, TStepTimer const& symbolTimer);
+
+	/* Destructor */
+	~ShiftKeying();
+
+	/* Create the frames of the symbols and start the stream with its first symbol.
+	 * Returns false, if the symbols can't be created with the given input frequency or not at the symbol rate,
+	 * or if the SPI driver dropped the first frame */
+	auto start(KeyingSettings const& settings, std::uint32_t const inputFrequency) const -> bool;
+
+	/* Stop at the current symbol */
+	auto stop(void) const -> void;
+
+	/* True until the end of the stream is reached (never for a repeated stream) or stop() is called */
+	auto isRunning(void) const -> bool { return running_; }
+
+	/* True, if the stream was stopped because the SPI driver dropped the frame of a symbol */
+	auto failed(void) const -> bool { return failed_; }
+
+	/* Time between two symbols in µs */
+	auto symbolInterval(void) const -> std::uint32_t { return symbolInterval_; }
+
+	/* Shortest time between two symbols in µs for the given frame size: The frame has to be sent completely */
+	auto minSymbolInterval(std::size_t const frameSize) const -> std::uint32_t
+	{
+		return synthesizer_.frameTransferTime(frameSize);
+	}
+
+private:
+
+	/* Handler of the symbol timer, runs in the interrupt */
+	auto step(void) const -> void;
+
+	mutable std::array<std::array<std::uint8_t, TDirectDigitalSynthesizer::maxFrameSize>, maxKeyingSymbols> frames_;
+	mutable std::array<std::uint8_t, TDirectDigitalSynthesizer::maxFrameSize> firstFrame_;	/* All registers of the first symbol */
+	mutable std::size_t frameSize_;
+	mutable std::uint8_t const* stream_;
+	mutable std::uint32_t streamLength_;
+	mutable std::uint32_t symbolInterval_;
+	mutable volatile std::uint32_t nextSymbol_;
+	mutable volatile bool repeat_;
+	mutable volatile bool running_;
+	mutable volatile bool failed_;
+
+	TDirectDigitalSynthesizer const& synthesizer_;
+	TStepTimer const& symbolTimer_;
+};
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+ShiftKeying<TDirectDigitalSynthesizer, TStepTimer>::
+ShiftKeying(TDirectDigitalSynthesizer const& synthesizer, TStepTimer const& symbolTimer) :
+	frames_(),
+	firstFrame_(),
+	frameSize_(0),
+	stream_(nullptr),
+	streamLength_(0),
+	symbolInterval_(0),
+	nextSymbol_(0),
+	repeat_(false),
+	running_(false),
+	failed_(false),
+	synthesizer_(synthesizer),
+	symbolTimer_(symbolTimer)
+{
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+ShiftKeying<TDirectDigitalSynthesizer, TStepTimer>::
+~ShiftKeying()
+{
+	stop();
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+auto ShiftKeying<TDirectDigitalSynthesizer, TStepTimer>::
+start(KeyingSettings const& settings, std::uint32_t const inputFrequency) const -> bool
+{
+	stop();
+	failed_ = false;
+
+	if ((settings.symbols == nullptr) || (settings.numOfSymbols < 2) || (settings.numOfSymbols > maxKeyingSymbols)
+			|| (settings.stream == nullptr) || (settings.streamLength == 0) || (settings.symbolRate == 0)
+			|| (inputFrequency == 0)) {
+		return false;
+	}
+
+	/* Every symbol needs a tuning word below the Nyquist frequency */
+	std::array<std::uint32_t, maxKeyingSymbols> tuningWords;
+	std::array<std::uint16_t, maxKeyingSymbols> phaseWords;
+	for (std::uint8_t i = 0; i < settings.numOfSymbols; i++) {
+		tuningWords[i] = TDirectDigitalSynthesizer::calculateTuningWord(inputFrequency, settings.symbols[i].frequency);
+		phaseWords[i] = TDirectDigitalSynthesizer::calculatePhaseWord(settings.symbols[i].phase);
+		if ((tuningWords[i] == 0) || (tuningWords[i] >= (1UL<<23))) {
+			return false;
+		}
+	}
+
+	/* Only the registers that differ between the symbols are written */
+	std::uint8_t registers = 0;
+	for (std::uint8_t i = 1; i < settings.numOfSymbols; i++) {
+		if ((tuningWords[i]>>8) != (tuningWords[0]>>8)) {
+			registers |= TDirectDigitalSynthesizer::FrameTuningWordHigh;
+		}
+		if ((tuningWords[i] & 0xFF) != (tuningWords[0] & 0xFF)) {
+			registers |= TDirectDigitalSynthesizer::FrameTuningWordLow;
+		}
+		if (phaseWords[i] != phaseWords[0]) {
+			registers |= TDirectDigitalSynthesizer::FramePhaseWord;
+		}
+	}
+
+	for (std::uint8_t i = 0; i < settings.numOfSymbols; i++) {
+		frameSize_ = TDirectDigitalSynthesizer::createFrame(registers, tuningWords[i], phaseWords[i], frames_[i].data());
+	}
+
+	/* The timer counts whole µs */
+	symbolInterval_ = (1000000 + (settings.symbolRate / 2)) / settings.symbolRate;
+	if ((symbolInterval_ < minSymbolInterval(frameSize_)) || (symbolInterval_ > TStepTimer::maxPeriod)) {
+		return false;
+	}
+
+	/* Symbols outside of the set would read beyond the frames */
+	for (std::uint32_t i = 0; i < settings.streamLength; i++) {
+		if (settings.stream[i] >= settings.numOfSymbols) {
+			return false;
+		}
+	}
+
+	stream_ = settings.stream;
+	streamLength_ = settings.streamLength;
+	repeat_ = settings.repeat;
+
+	/* Send the first symbol right away with all registers, the others follow from the timer interrupt */
+	std::uint8_t const first = stream_[0];
+	std::size_t const firstFrameSize = TDirectDigitalSynthesizer::createFrame(TDirectDigitalSynthesizer::FrameTuningWordHigh
+			| TDirectDigitalSynthesizer::FrameTuningWordLow | TDirectDigitalSynthesizer::FramePhaseWord,
+			tuningWords[first], phaseWords[first], firstFrame_.data());
+	if (not synthesizer_.writeFrame(firstFrame_.data(), firstFrameSize)) {
+		failed_ = true;
+		return false;
+	}
+
+	nextSymbol_ = 1;
+	running_ = (streamLength_ > 1) || repeat_;
+	if (not running_) {
+		return true;
+	}
+
+	symbolTimer_.setCallbackHandler([this]() {
+		this->step();
+	});
+	symbolTimer_.start(symbolInterval_);
+
+	return true;
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+auto ShiftKeying<TDirectDigitalSynthesizer, TStepTimer>::
+stop(void) const -> void
+{
+	if (running_) {
+		symbolTimer_.stop();
+		running_ = false;
+	}
+}
+
+
+template <typename TDirectDigitalSynthesizer, typename TStepTimer>
+auto ShiftKeying<TDirectDigitalSynthesizer, TStepTimer>::
+step(void) const -> void
+{
+	if (nextSymbol_ >= streamLength_) {
+		if (not repeat_) {
+			/* Stay at the last symbol */
+			symbolTimer_.stop();
+			running_ = false;
+			return;
+		}
+		nextSymbol_ = 0;
+	}
+
+	if (not synthesizer_.writeFrame(frames_[stream_[nextSymbol_]].data(), frameSize_)) {
+		/* A missing symbol would corrupt the rest of the stream */
+		symbolTimer_.stop();
+		running_ = false;
+		failed_ = true;
+		return;
+	}
+	nextSymbol_ = nextSymbol_ + 1;
+}
+
+
+} /* namespace SignalGeneration */
+
+#endif /* SHIFTKEYING_H_ */
@@ -21,11 +21,78 @@ enum Waveform : std::uint32_t {
 	Triangle,
 	Saw_pos,
 	Saw_neg,
+	Arbitrary,
 
 	Waveformcount
 };
 
 
+/* Interpolation between the points of an arbitrary waveform */
+enum class Interpolation : std::uint8_t {
+	Linear,
+	Cubic
+};
+
+
+/* One period of an arbitrary waveform, given as equally spaced points.
+ * The points are not copied, so they have to stay valid as long as the waveform is used */
+struct ArbitraryWaveform {
+	std::int16_t const*	points;
+	std::uint16_t		numOfPoints;
+	Interpolation		interpolation;
+};
+
+
+/* Course of the frequency during a sweep or chirp */
+enum class SweepLaw : std::uint8_t {
+	Linear,			/* Same frequency difference between all steps */
+	Logarithmic		/* Same frequency ratio between all steps */
+};
+
+
+/* Chirp played by the DDS itself from tuning words in its SRAM. It restarts after each duration */
+struct ChirpSettings {
+	std::uint32_t	startFrequency;
+	std::uint32_t	stopFrequency;
+	SweepLaw		law;
+	std::uint32_t	duration;		/* Time from start to stop frequency in µs */
+};
+
+
+/* Source of the trigger starting a burst */
+enum class BurstTrigger : std::uint8_t {
+	Software,		/* Each call of triggerBurst() */
+	Timer			/* Periodically from the timer manager */
+};
+
+/* Burst of a fixed number of periods per trigger. The periods are counted by the DDS itself */
+struct BurstSettings {
+	std::uint16_t	numOfCycles;	/* Periods per trigger, zero for continuous output */
+	BurstTrigger	trigger;
+	std::uint32_t	period;			/* Time between two timer triggers in ms */
+};
+
+
+/* Frequency and phase of one symbol of a shift keying (FSK, PSK or both) */
+struct KeyingSymbol {
+	std::uint32_t	frequency;
+	std::int32_t	phase;			/* Degree, -180 to 180 */
+};
+
+static const std::uint8_t maxKeyingSymbols = 4;
+
+/* Shift keying: One symbol of the stream per symbol period. The symbols are only read at the start,
+ * the stream isn't copied, so it has to stay valid as long as it is played */
+struct KeyingSettings {
+	KeyingSymbol const*		symbols;
+	std::uint8_t			numOfSymbols;	/* 2 to maxKeyingSymbols */
+	std::uint8_t const*		stream;			/* Index of the symbol for each symbol period */
+	std::uint32_t			streamLength;
+	std::uint32_t			symbolRate;		/* Symbols per second */
+	bool					repeat;			/* Restart the stream at its end, otherwise stay at the last symbol */
+};
+
+
 /* Default values */
 static const Waveform defaultWaveform = Waveform::Sine;
 static const std::uint32_t defaultFrequency = 1000;	// 1kHz
@@ -67,6 +134,31 @@ struct ChannelSettings{
 };
 
 
+/* Internal sawtooth generator of the AD9102: Each of the 16384 DAC codes is held for SAW_STEP
+ * clock cycles. A ramp passes all codes once per period, a triangle twice. */
+static const std::uint32_t sawNumOfCodes = 16384;
+static const std::uint32_t sawMaxStep = 63;
+
+/* Clock cycles per period of the sawtooth generator for a SAW_STEP of one. Zero if the generator
+ * can't create the signal (other waveforms, or a phase shift, which it doesn't support) */
+inline auto sawCyclesPerStep(ChannelSettings const& settings) -> std::uint32_t
+{
+	if (settings.phase_ != 0) {
+		return 0;
+	}
+
+	switch (settings.form_) {
+		case Waveform::Saw_pos:
+		case Waveform::Saw_neg:
+			return sawNumOfCodes;
+		case Waveform::Triangle:
+			return 2 * sawNumOfCodes;
+		default:
+			return 0;
+	}
+}
+
+
 }; // end namespace SignalGeneration
 
 #endif
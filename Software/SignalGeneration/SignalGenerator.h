@@ -3,19 +3,27 @@
 #define SIGNALGENERATOR_H_
 
 
+#include <chrono>
+
 #include "SignalGenerationCommon.h"
+#include "FrequencyPlanner.h"
+#include "FrequencySweep.h"
+#include "ShiftKeying.h"
+#include "SettingsDiff.h"
 
 
 namespace SignalGeneration {
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
 class SignalGenerator
 {
 public:
 
+	typedef typename Timer::IdType IdType;
+
 	/* Constructor */
 	SignalGenerator(Output const outputChannel, Synthesizer const& synthesizer, FrequencyMgr const& frequencyMgr,
-			VoltageHelper const& voltageHelper);
+			VoltageHelper const& voltageHelper, Sweeper const& sweeper, Keyer const& keyer, Timer const& timer);
 
 	/* Destructor */
 	~SignalGenerator();
@@ -34,9 +42,95 @@ public:
 	auto setPhase(std::int32_t const phase) const -> void;
 	auto setDutyCycle(std::uint32_t const dutyCyclePercent) const -> void;
 
+	/* Set the points played with Waveform::Arbitrary, a sinc pulse is built in until then.
+	 * The points have to stay valid as long as they are used */
+	auto setArbitraryWaveform(ArbitraryWaveform const& waveform) const -> void;
+
+	/* Prefer many samples (fine waveform) or few samples (fast SRAM upload) for SRAM patterns */
+	auto setSamplePreference(SamplePreference const preference) const -> void;
+
+	/* Transaction: Between begin() and commit(), the setters only collect their changes. commit() plans
+	 * the clock and writes the synthesizer once for all of them, e.g. to restore a stored state */
+	auto begin(void) const -> void { transactionOpen_ = true; }
+	auto commit(void) const -> void;
+
+	/* Number of applied changes that took the given hardware path */
+	auto getChangeCount(ChangePath const path) const -> std::uint32_t { return settingsDiff_.count(path); }
+
+	/* Signal frequency actually generated and its deviation from the requested one in mHz */
+	auto getAchievedFrequency(void) const -> std::uint32_t { return frequencyPlan_.achievedFrequency; }
+	auto getFrequencyError(void) const -> std::int32_t { return frequencyPlan_.frequencyError; }
+
+	/* Sweep the frequency of a sine signal. The frequency setting itself stays unchanged, the setters
+	 * of the signal end the sweep. Returns false, if the waveform isn't sine or the sweep can't be created */
+	auto startSweep(SweepSettings const& settings) const -> bool;
+
+	/* End the sweep and return to the frequency setting */
+	auto stopSweep(void) const -> void;
+
+	/* True while the sweep is stepping (a one-shot sweep stays at its stop frequency until stopSweep()) */
+	auto isSweepRunning(void) const -> bool { return sweepActive_ and sweeper_.isRunning(); }
+
+	/* Largest deviation of the sweep steps from their nominal time in ns */
+	auto getSweepJitter(void) const -> std::uint32_t { return sweeper_.maxStepJitter(); }
+
+	/* Repeat a chirp of a sine signal, played by the synthesizer from its SRAM without further interrupts.
+	 * Like the sweep, it ends with the setters of the signal. Returns false, if the waveform isn't sine
+	 * or the chirp can't be created */
+	auto startChirp(ChirpSettings const& chirp) const -> bool;
+
+	/* End the chirp and return to the frequency setting */
+	auto stopChirp(void) const -> void { stopSweep(); }
+
+	auto isChirpActive(void) const -> bool { return chirpActive_; }
+
+	/* Hop a sine signal between the frequencies and phases of the symbols (FSK / PSK). Like the sweep, it
+	 * ends with the setters of the signal. Returns false, if the waveform isn't sine or the symbols can't
+	 * be played at the symbol rate */
+	auto startKeying(KeyingSettings const& settings) const -> bool;
+
+	/* End the keying and return to the frequency and phase setting */
+	auto stopKeying(void) const -> void { stopSweep(); }
+
+	/* True while the symbols of the stream are played */
+	auto isKeyingRunning(void) const -> bool { return keyingActive_ and keyer_.isRunning(); }
+
+	/* True, if the keying stopped early because the SPI driver dropped the frame of a symbol */
+	auto hasKeyingFailed(void) const -> bool { return keyingActive_ and keyer_.failed(); }
+
+	/* Output a burst of a fixed number of periods per trigger instead of a continuous signal, zero periods return
+	 * to continuous output. The periods are counted by the synthesizer, the MCU only triggers. Ends a sweep or chirp.
+	 * Returns false, if the synthesizer can't create the burst with the current settings or if the channel sharing
+	 * the trigger outputs a continuous signal: Its restarts would trigger bursts, the bursts would stop its output */
+	auto setBurst(BurstSettings const& settings) const -> bool;
+
+	/* True, if the channel outputs bursts instead of a continuous signal */
+	auto isBurstMode(void) const -> bool { return burst_.numOfCycles != 0; }
+
+	auto isSignalOutputEnabled(void) const -> bool { return outputEnabled_; }
+
+	/* Channel whose synthesizer is connected to the same trigger pin */
+	auto setTriggerSharedWith(SignalGenerator const& other) const -> void { triggerSharedWith_ = &other; }
+
+	/* Start one burst, if bursts are triggered by software */
+	auto triggerBurst(void) const -> void;
+
 
 private:
 
+	/* Pulse the trigger of the synthesizer. Long pulses are ended by the timer instead of busy waiting */
+	auto pulseTrigger(void) const -> void;
+
+	/* Plan the synthesizer input frequency for the current settings and set it */
+	auto updateFrequencyPlan(void) const -> void;
+
+	/* Stop a sweep, chirp or keying before the settings are applied again.
+	 * Returns true, if one was active and the input frequency was planned again */
+	auto cancelSweep(void) const -> bool;
+
+	/* Run the stages affected by the changes since the last call in a fixed order, unless a transaction is open */
+	auto applyPendingChanges(void) const -> void;
+
 	/* Store the output channel to where the generated signal is going */
 	Output outputChannel_;
 
@@ -46,40 +140,84 @@ private:
 	/* Store the current system frequency */
 	mutable std::uint32_t systemFrequency_;
 
+	/* Plan the system frequency was chosen with */
+	mutable FrequencyPlan frequencyPlan_;
+	mutable SamplePreference samplePreference_;
+
 	/* Store the current state of the output signal */
 	mutable bool outputEnabled_;
 
+	/* Settings the hardware was last set to. The difference to the current settings selects the stages to run */
+	mutable ChannelSettings appliedSettings_;
+	mutable SettingsDiff settingsDiff_;
+
+	/* Stages to run even without a difference of the settings (SettingsDiff::Stage flags) */
+	mutable std::uint8_t pendingChanges_;
+	mutable bool signalChangeRequested_;
+	mutable bool transactionOpen_;
+
+	/* The sweep, the chirp or the keying owns the tuning word of the synthesizer */
+	mutable bool sweepActive_;
+	mutable bool chirpActive_;
+	mutable bool keyingActive_;
+
+	/* Burst mode and the periodic trigger of the timer */
+	mutable BurstSettings burst_;
+	mutable IdType burstTimerId_;
+	mutable SignalGenerator const* triggerSharedWith_;
+
 	Synthesizer const& synthesizer_;
 	FrequencyMgr const& frequencyMgr_;
 	VoltageHelper const& voltageHelper_;
+	Sweeper const& sweeper_;
+	Keyer const& keyer_;
+	Timer const& timer_;
 };
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 SignalGenerator(Output const outputChannel, Synthesizer const& synthesizer, FrequencyMgr const& frequencyMgr,
-		VoltageHelper const& voltageHelper) :
+		VoltageHelper const& voltageHelper, Sweeper const& sweeper, Keyer const& keyer, Timer const& timer) :
 	outputChannel_(outputChannel),
 	currentSettings_(),
 	systemFrequency_(frequencyMgr.getCurrentFrequency(outputChannel_)),
+	frequencyPlan_(),
+	samplePreference_(SamplePreference::Resolution),
 	outputEnabled_(false),
+	appliedSettings_(),
+	settingsDiff_(),
+	pendingChanges_(0),
+	signalChangeRequested_(false),
+	transactionOpen_(false),
+	sweepActive_(false),
+	chirpActive_(false),
+	keyingActive_(false),
+	burst_(),
+	burstTimerId_(0),
+	triggerSharedWith_(nullptr),
 	synthesizer_(synthesizer),
 	frequencyMgr_(frequencyMgr),
-	voltageHelper_(voltageHelper)
+	voltageHelper_(voltageHelper),
+	sweeper_(sweeper),
+	keyer_(keyer),
+	timer_(timer)
 {
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 ~SignalGenerator()
 {
-
+	if (burstTimerId_ != 0) {
+		timer_.abort(burstTimerId_);
+	}
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 initialize(ChannelSettings const& storedSettings) const -> void
 {
 	/* Store settings */
@@ -107,32 +245,25 @@ initialize(ChannelSettings const& storedSettings) const -> void
 		currentSettings_.dutyCycle_ = defaultDutyCycle;
 	}
 
-	/* Store settings */
-	currentSettings_ = storedSettings;
-
 	/* Initalize sub components */
 	synthesizer_.initialize();
 
-	/* Calculate and set DDS input frequency using the FrequencyMgr */
-	systemFrequency_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, storedSettings);
-
-	/* Apply stored settings. By calling setWaveform() we also update the frequency,
-	 * phase and dutyCycle (if relevant) of the signal */
-	setWaveform(storedSettings.form_);
-	setAmplitude(storedSettings.amplitude_);
-	setOffset(storedSettings.offset_);
+	/* Apply the checked settings at once: Input frequency, signal, amplitude and offset */
+	pendingChanges_ = SettingsDiff::ClockStage | SettingsDiff::SynthesizerStage | SettingsDiff::AmplitudeStage | SettingsDiff::OffsetStage;
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setSignalOutputEnabled(bool const enable) const -> void
 {
 	outputEnabled_ = enable;
 
 	if (enable) {
 		/* If the signal is enabled, apply correct offset */
-		setOffset(currentSettings_.offset_);
+		pendingChanges_ |= SettingsDiff::OffsetStage;
+		applyPendingChanges();
 	}
 	else {
 		/* Otherwise set offset to zero */
@@ -144,18 +275,19 @@ setSignalOutputEnabled(bool const enable) const -> void
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setWaveform(Waveform const form) const -> void
 {
 	currentSettings_.form_ = form;
+	signalChangeRequested_ = true;
 
-	synthesizer_.setOutput(currentSettings_, systemFrequency_);
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setFrequency(std::uint32_t const frequency) const -> void
 {
 	/* Update local data */
@@ -167,15 +299,14 @@ setFrequency(std::uint32_t const frequency) const -> void
 		currentSettings_.frequency_ = defaultFrequency;
 	}
 
-	/* Calculate and set an appropriate synthesizer input frequency */
-	systemFrequency_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, currentSettings_);
+	signalChangeRequested_ = true;
 
-	synthesizer_.setOutput(currentSettings_, systemFrequency_);
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setAmplitude(std::uint32_t const amplitude) const -> void
 {
 	/* Updata local data */
@@ -186,17 +317,12 @@ setAmplitude(std::uint32_t const amplitude) const -> void
 		currentSettings_.amplitude_ = defaultAmplitude;
 	}
 
-	/* To set the amplitude of the output signal, we have to set the reference
-	 * voltage of the DDS to a value between 0V and 5V
-	 * 0V	=> 0V
-	 * 5V => 10V */
-	std::uint16_t refVoltage = amplitude * 5;
-	voltageHelper_.setAmplitudeVoltage(outputChannel_, refVoltage);
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setOffset(std::int32_t const offset) const -> void
 {
 	/* Update local data */
@@ -207,24 +333,12 @@ setOffset(std::int32_t const offset) const -> void
 		currentSettings_.offset_ = defaultOffset;
 	}
 
-	/* Only set offset if the signal output is enabled */
-	if (outputEnabled_) {
-		/* To set the offset voltage of the output signal, we have to set the reference
-		 * voltage of the voltage adder circuit to a value between -2V to +2V.
-		 * This voltage is added onto the raw signal and the result is then multiplied
-		 * by 5 in the final amplification stage. */
-		std::int16_t refVoltage = offset * 2;
-
-		voltageHelper_.setOffsetVoltage(outputChannel_, refVoltage);
-	}
-	else {
-		voltageHelper_.setOffsetVoltage(outputChannel_, 0);
-	}
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setPhase(std::int32_t const phase) const -> void
 {
 	/* Update local data */
@@ -235,15 +349,14 @@ setPhase(std::int32_t const phase) const -> void
 		currentSettings_.phase_ = defaultPhase;
 	}
 
-	/* Re-calculate synthesizer input frequency */
-	//systemFrequency_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, currentSettings_);
+	signalChangeRequested_ = true;
 
-	synthesizer_.setOutput(currentSettings_, systemFrequency_);
+	applyPendingChanges();
 }
 
 
-template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper>
-auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper>::
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
 setDutyCycle(std::uint32_t const dutyCyclePercent) const -> void
 {
 	/* Update local data */
@@ -254,10 +367,357 @@ setDutyCycle(std::uint32_t const dutyCyclePercent) const -> void
 		currentSettings_.dutyCycle_ = defaultDutyCycle;
 	}
 
-	/* Re-calculate synthesizer input frequency */
-	//systemFrequency_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, currentSettings_);
+	signalChangeRequested_ = true;
+
+	applyPendingChanges();
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+setArbitraryWaveform(ArbitraryWaveform const& waveform) const -> void
+{
+	synthesizer_.setArbitraryWaveform(waveform);
+
+	/* Update the output, if the arbitrary waveform is currently played */
+	if (currentSettings_.form_ == Waveform::Arbitrary) {
+		pendingChanges_ |= SettingsDiff::SynthesizerStage;
+		applyPendingChanges();
+	}
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+setSamplePreference(SamplePreference const preference) const -> void
+{
+	if (preference == samplePreference_) {
+		return;
+	}
+
+	samplePreference_ = preference;
+
+	/* The preference changes the number of samples and with it the input frequency */
+	pendingChanges_ |= SettingsDiff::ClockStage | SettingsDiff::SynthesizerStage;
+
+	applyPendingChanges();
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+commit(void) const -> void
+{
+	transactionOpen_ = false;
+
+	applyPendingChanges();
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+applyPendingChanges(void) const -> void
+{
+	if (transactionOpen_) {
+		return;
+	}
+
+	std::uint8_t stages = SettingsDiff::stages(appliedSettings_, currentSettings_) | pendingChanges_;
+
+	/* A running sweep, chirp or keying ends with every setter of the signal, even without a change */
+	if (signalChangeRequested_ and (sweepActive_ or chirpActive_ or keyingActive_)) {
+		stages |= SettingsDiff::SynthesizerStage;
+	}
+
+	pendingChanges_ = 0;
+	signalChangeRequested_ = false;
+
+	if (stages == 0) {
+		return;
+	}
+
+	std::uint32_t const previousInputFrequency = systemFrequency_;
+
+	/* Clock first, so the synthesizer is written only once with the final input frequency */
+	if (stages & (SettingsDiff::ClockStage | SettingsDiff::SynthesizerStage)) {
+		bool const replanned = cancelSweep();
+
+		if ((stages & SettingsDiff::ClockStage) and (not replanned)) {
+			updateFrequencyPlan();
+		}
+
+		synthesizer_.setOutput(currentSettings_, systemFrequency_);
+	}
+
+	if (stages & SettingsDiff::AmplitudeStage) {
+		/* To set the amplitude of the output signal, we have to set the reference
+		 * voltage of the DDS to a value between 0V and 5V
+		 * 0V	=> 0V
+		 * 5V => 10V */
+		std::uint16_t refVoltage = currentSettings_.amplitude_ * 5;
+		voltageHelper_.setAmplitudeVoltage(outputChannel_, refVoltage);
+	}
+
+	if (stages & SettingsDiff::OffsetStage) {
+		/* Only set offset if the signal output is enabled */
+		if (outputEnabled_) {
+			/* To set the offset voltage of the output signal, we have to set the reference
+			 * voltage of the voltage adder circuit to a value between -2V to +2V.
+			 * This voltage is added onto the raw signal and the result is then multiplied
+			 * by 5 in the final amplification stage. */
+			std::int16_t refVoltage = currentSettings_.offset_ * 2;
+
+			voltageHelper_.setOffsetVoltage(outputChannel_, refVoltage);
+		}
+		else {
+			voltageHelper_.setOffsetVoltage(outputChannel_, 0);
+		}
+	}
+
+	appliedSettings_ = currentSettings_;
+	settingsDiff_.record(stages, systemFrequency_ != previousInputFrequency,
+			Synthesizer::usesSramPattern(currentSettings_, systemFrequency_));
+}
+
 
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+updateFrequencyPlan(void) const -> void
+{
+	frequencyPlan_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, currentSettings_, samplePreference_);
+	systemFrequency_ = frequencyPlan_.inputFrequency;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+startSweep(SweepSettings const& settings) const -> bool
+{
+	cancelSweep();
+
+	if ((currentSettings_.form_ != Waveform::Sine)
+			|| (settings.startFrequency < minFrequency) || (settings.startFrequency > maxFrequency)
+			|| (settings.stopFrequency < minFrequency) || (settings.stopFrequency > maxFrequency)) {
+		return false;
+	}
+
+	/* Plan the input frequency for the highest frequency of the sweep, all others are reached
+	 * with the tuning word alone */
+	ChannelSettings sweepSettings = currentSettings_;
+	sweepSettings.frequency_ = (settings.startFrequency > settings.stopFrequency) ? settings.startFrequency : settings.stopFrequency;
+
+	frequencyPlan_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, sweepSettings, samplePreference_);
+	systemFrequency_ = frequencyPlan_.inputFrequency;
+
+	/* Begin with the start frequency, the steps follow from the timer interrupt */
+	sweepSettings.frequency_ = settings.startFrequency;
+	synthesizer_.setOutput(sweepSettings, systemFrequency_);
+
+	if (not sweeper_.start(settings, systemFrequency_)) {
+		updateFrequencyPlan();
+		synthesizer_.setOutput(currentSettings_, systemFrequency_);
+		return false;
+	}
+
+	synthesizer_.invalidateFrameRegisters();
+	sweepActive_ = true;
+
+	return true;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+stopSweep(void) const -> void
+{
+	if (not (sweepActive_ or chirpActive_ or keyingActive_)) {
+		return;
+	}
+
+	cancelSweep();
+
+	synthesizer_.setOutput(currentSettings_, systemFrequency_);
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+cancelSweep(void) const -> bool
+{
+	if (not (sweepActive_ or chirpActive_ or keyingActive_)) {
+		return false;
+	}
+
+	if (sweepActive_ or keyingActive_) {
+		sweeper_.stop();
+		keyer_.stop();
+		synthesizer_.invalidateFrameRegisters();
+	}
+	sweepActive_ = false;
+	chirpActive_ = false;
+	keyingActive_ = false;
+
+	/* The input frequency was planned for the sweep, chirp or keying */
+	updateFrequencyPlan();
+
+	return true;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+startKeying(KeyingSettings const& settings) const -> bool
+{
+	cancelSweep();
+
+	if ((currentSettings_.form_ != Waveform::Sine) || (settings.symbols == nullptr) || (settings.numOfSymbols < 2)
+			|| (settings.numOfSymbols > maxKeyingSymbols) || (settings.stream == nullptr) || (settings.streamLength == 0)
+			|| (settings.stream[0] >= settings.numOfSymbols)) {
+		return false;
+	}
+
+	/* Plan the input frequency for the highest frequency of the symbols, all of them are reached
+	 * with the tuning word alone */
+	ChannelSettings keyingSettings = currentSettings_;
+	keyingSettings.frequency_ = 0;
+	for (std::uint8_t i = 0; i < settings.numOfSymbols; i++) {
+		if ((settings.symbols[i].frequency < minFrequency) || (settings.symbols[i].frequency > maxFrequency)) {
+			return false;
+		}
+		if (settings.symbols[i].frequency > keyingSettings.frequency_) {
+			keyingSettings.frequency_ = settings.symbols[i].frequency;
+		}
+	}
+
+	frequencyPlan_ = frequencyMgr_.setFrequencyForChannel(outputChannel_, keyingSettings, samplePreference_);
+	systemFrequency_ = frequencyPlan_.inputFrequency;
+
+	/* Begin with the first symbol, the others follow from the timer interrupt */
+	keyingSettings.frequency_ = settings.symbols[settings.stream[0]].frequency;
+	keyingSettings.phase_ = settings.symbols[settings.stream[0]].phase;
+	synthesizer_.setOutput(keyingSettings, systemFrequency_);
+
+	if (not keyer_.start(settings, systemFrequency_)) {
+		updateFrequencyPlan();
+		synthesizer_.setOutput(currentSettings_, systemFrequency_);
+		return false;
+	}
+
+	synthesizer_.invalidateFrameRegisters();
+	keyingActive_ = true;
+
+	return true;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+startChirp(ChirpSettings const& chirp) const -> bool
+{
+	cancelSweep();
+
+	if ((currentSettings_.form_ != Waveform::Sine) || (chirp.duration == 0)
+			|| (chirp.startFrequency < minFrequency) || (chirp.startFrequency > maxFrequency)
+			|| (chirp.stopFrequency < minFrequency) || (chirp.stopFrequency > maxFrequency)) {
+		return false;
+	}
+
+	/* The fastest input frequency whose clock cycles of the chirp still fit into the SRAM */
+	std::uint64_t inputFrequency = FrequencyPlanner::maxInputFrequency;
+	std::uint64_t const fittingFrequency = (static_cast<std::uint64_t>(Synthesizer::maxChirpClocks) * 1000000) / chirp.duration;
+	if (fittingFrequency < inputFrequency) {
+		inputFrequency = fittingFrequency;
+	}
+
+	/* At least four clock cycles per period of the highest frequency */
+	std::uint32_t const highestFrequency = (chirp.startFrequency > chirp.stopFrequency) ? chirp.startFrequency : chirp.stopFrequency;
+	if (inputFrequency < (4 * static_cast<std::uint64_t>(highestFrequency))) {
+		return false;
+	}
+
+	FrequencyPlan const plan = frequencyMgr_.setInputFrequencyForChannel(outputChannel_, static_cast<std::uint32_t>(inputFrequency));
+	if (plan.inputFrequency == 0) {
+		return false;
+	}
+
+	frequencyPlan_ = plan;
+	systemFrequency_ = plan.inputFrequency;
+
+	if (not synthesizer_.setChirp(chirp, systemFrequency_)) {
+		updateFrequencyPlan();
+		synthesizer_.setOutput(currentSettings_, systemFrequency_);
+		return false;
+	}
+
+	chirpActive_ = true;
+
+	return true;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+setBurst(BurstSettings const& settings) const -> bool
+{
+	/* Both channels may burst from the same trigger, but a continuous signal needs the trigger for itself */
+	if ((settings.numOfCycles != 0) && (triggerSharedWith_ != nullptr) && triggerSharedWith_->isSignalOutputEnabled()
+			&& (not triggerSharedWith_->isBurstMode())) {
+		return false;
+	}
+
+	cancelSweep();
+
+	if ((settings.numOfCycles > Synthesizer::maxBurstCycles)
+			|| (Synthesizer::burstPatternClocks(currentSettings_, systemFrequency_, settings.numOfCycles) > Synthesizer::maxPatternClocks)
+			|| ((settings.numOfCycles != 0) && (settings.trigger == BurstTrigger::Timer) && (settings.period == 0))) {
+		return false;
+	}
+
+	if (burstTimerId_ != 0) {
+		/* abort() only clears the id if the timer was still known, it must not be aborted again later */
+		timer_.abort(burstTimerId_);
+		burstTimerId_ = 0;
+	}
+
+	burst_ = settings;
+
+	/* Entering burst mode restarts the synthesizer, which starts the first burst */
+	synthesizer_.setBurstCycles(settings.numOfCycles);
 	synthesizer_.setOutput(currentSettings_, systemFrequency_);
+
+	if ((settings.numOfCycles != 0) && (settings.trigger == BurstTrigger::Timer)) {
+		burstTimerId_ = timer_.asyncRepeat(std::chrono::milliseconds(settings.period), [this]() {
+			this->pulseTrigger();
+		});
+	}
+
+	return true;
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+triggerBurst(void) const -> void
+{
+	if ((burst_.numOfCycles != 0) && (burst_.trigger == BurstTrigger::Software)) {
+		pulseTrigger();
+	}
+}
+
+
+template <typename Synthesizer, typename FrequencyMgr, typename VoltageHelper, typename Sweeper, typename Keyer, typename Timer>
+auto SignalGenerator<Synthesizer, FrequencyMgr, VoltageHelper, Sweeper, Keyer, Timer>::
+pulseTrigger(void) const -> void
+{
+	if (synthesizer_.triggerBurst(systemFrequency_)) {
+		return;
+	}
+
+	/* The timer counts whole ms, one more makes sure the pulse isn't cut short */
+	std::uint32_t const pulseTime = ((Synthesizer::triggerPulseTime(systemFrequency_) + 999) / 1000) + 1;
+	timer_.asyncWait(std::chrono::milliseconds(pulseTime), [this]() {
+		this->synthesizer_.releaseTrigger();
+	});
 }
 
 
@@ -0,0 +1,319 @@
+#ifndef SRAMSLOTALLOCATOR_H_
+#define SRAMSLOTALLOCATOR_H_
+
+#include <cstdint>
+#include <array>
+
+#include "SignalGenerationCommon.h"
+
+
+namespace SignalGeneration {
+
+
+/* CRC-32 (IEEE 802.3) of size bytes, continuing the CRC of preceding data. Bitwise, as it only runs when the
+ * content of a pattern is set, not per sample */
+inline auto crc32(void const* const data, std::size_t const size, std::uint32_t crc = 0) -> std::uint32_t
+{
+	std::uint8_t const* bytes = static_cast<std::uint8_t const*>(data);
+
+	crc = ~crc;
+	for (std::size_t i = 0; i < size; i++) {
+		crc ^= bytes[i];
+		for (std::uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 0x01)));
+		}
+	}
+
+	return ~crc;
+}
+
+
+/* Description of a pattern stored in the SRAM of the DDS */
+struct SramResidency {
+	Waveform		form;
+	std::uint16_t	numOfSamples;
+	std::int32_t	phaseShift;		/* Phase in degree */
+	std::uint32_t	dutyCycle;		/* Only relevant for Waveform::Rect, zero otherwise */
+	std::uint32_t	contentHash;	/* crc32() of the points of Waveform::Arbitrary or the tuning words of a chirp, zero otherwise */
+	bool			valid;
+
+	/* Check if the parameters describe the same pattern */
+	bool describesSamePattern(SramResidency const& other) const {
+		return valid && other.valid && (form == other.form) && (numOfSamples == other.numOfSamples)
+				&& (phaseShift == other.phaseShift) && (dutyCycle == other.dutyCycle) && (contentHash == other.contentHash);
+	}
+};
+
+
+/* Class SramSlotAllocator
+ * 	Manages several patterns inside the SRAM of the DDS at the same time. Each pattern occupies a
+ * 	contiguous range of SRAM addresses (a slot). Switching between resident patterns then only
+ * 	needs new start and stop addresses instead of a complete upload.
+ *
+ * 	New slots are placed at the lowest free address range that is large enough (first fit).
+ * 	If there is no such range, slots holding their pattern twice are shrunk to a single copy first,
+ * 	the least recently used one first. Only then the least recently used slots are evicted one after
+ * 	another until the new slot fits. A protected slot (e.g. the one currently played) is never touched.
+ *
+ * 	@template TMaxNumOfSlots - Maximum number of patterns resident at the same time
+ */
+template <std::size_t TMaxNumOfSlots = 8>
+class SramSlotAllocator
+{
+public:
+
+	/* Size of the SRAM in samples */
+	static constexpr std::uint16_t sramSize = 4096;
+
+	/* Returned if no slot is available */
+	static constexpr std::int8_t invalidSlot = -1;
+
+	struct Slot {
+		SramResidency	pattern;
+		std::uint16_t	startAddr;
+		std::uint16_t	length;		/* Number of SRAM words occupied by the slot, pattern.numOfSamples or twice as many */
+		std::uint32_t	lastUse;
+	};
+
+	/* Constructor */
+	SramSlotAllocator();
+
+	/* Find the slot holding the given pattern */
+	auto find(SramResidency const& pattern) const -> std::int8_t;
+
+	/* Reserve a slot with the given length. Shrinks or evicts least recently used slots if necessary.
+	 * The content of the returned slot is invalid until setPattern() is called */
+	auto allocate(std::uint16_t const length, std::int8_t const protectedSlot = invalidSlot) const -> std::int8_t;
+
+	/* Store the description of the pattern written into the slot */
+	auto setPattern(std::int8_t const index, SramResidency const& pattern) const -> void;
+
+	/* Mark the slot as used right now */
+	auto touch(std::int8_t const index) const -> void;
+
+	/* Free the slot, e.g. if its pattern couldn't be written completely */
+	auto release(std::int8_t const index) const -> void;
+
+	/* Forget about all slots, e.g. after a reset of the DDS */
+	auto invalidateAll(void) const -> void;
+
+	auto slot(std::int8_t const index) const -> Slot const& { return slots_[index]; }
+
+
+private:
+
+	/* Lowest start address where a slot with the given length fits. Returns sramSize if there is none */
+	auto findFreeRange(std::uint16_t const length) const -> std::uint16_t;
+
+	/* Drop the second copy of the least recently used pattern stored twice. Returns false if there is none */
+	auto shrinkLeastRecentlyUsed(std::int8_t const protectedSlot) const -> bool;
+
+	/* Evict the least recently used slot. Returns false if there was nothing to evict */
+	auto evictLeastRecentlyUsed(std::int8_t const protectedSlot) const -> bool;
+
+	/* Slots in use, either just allocated or holding a pattern */
+	mutable std::array<bool, TMaxNumOfSlots> reserved_;
+	mutable std::array<Slot, TMaxNumOfSlots> slots_;
+	mutable std::uint32_t useCounter_;
+};
+
+
+template <std::size_t TMaxNumOfSlots>
+SramSlotAllocator<TMaxNumOfSlots>::
+SramSlotAllocator() :
+	useCounter_(0)
+{
+	invalidateAll();
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+find(SramResidency const& pattern) const -> std::int8_t
+{
+	for (std::size_t i = 0; i < TMaxNumOfSlots; i++) {
+		if (reserved_[i] && pattern.describesSamePattern(slots_[i].pattern)) {
+			return static_cast<std::int8_t>(i);
+		}
+	}
+
+	return invalidSlot;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+allocate(std::uint16_t const length, std::int8_t const protectedSlot) const -> std::int8_t
+{
+	if ((length == 0) || (length > sramSize)) {
+		return invalidSlot;
+	}
+
+	while (true) {
+		/* Search a free entry in the slot table and a free range in the SRAM */
+		std::int8_t freeEntry = invalidSlot;
+		for (std::size_t i = 0; i < TMaxNumOfSlots; i++) {
+			if (not reserved_[i]) {
+				freeEntry = static_cast<std::int8_t>(i);
+				break;
+			}
+		}
+
+		std::uint16_t startAddr = findFreeRange(length);
+
+		if ((freeEntry != invalidSlot) && (startAddr < sramSize)) {
+			reserved_[freeEntry] = true;
+			slots_[freeEntry].pattern.valid = false;
+			slots_[freeEntry].startAddr = startAddr;
+			slots_[freeEntry].length = length;
+			touch(freeEntry);
+
+			return freeEntry;
+		}
+
+		/* Does not fit: Make room by dropping second copies, then by evicting the least recently used pattern */
+		if (shrinkLeastRecentlyUsed(protectedSlot)) {
+			continue;
+		}
+		if (not evictLeastRecentlyUsed(protectedSlot)) {
+			return invalidSlot;
+		}
+	}
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+setPattern(std::int8_t const index, SramResidency const& pattern) const -> void
+{
+	slots_[index].pattern = pattern;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+touch(std::int8_t const index) const -> void
+{
+	slots_[index].lastUse = ++useCounter_;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+release(std::int8_t const index) const -> void
+{
+	reserved_[index] = false;
+	slots_[index].pattern.valid = false;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+invalidateAll(void) const -> void
+{
+	reserved_.fill(false);
+
+	for (auto& slot : slots_) {
+		slot.pattern.valid = false;
+		slot.startAddr = 0;
+		slot.length = 0;
+		slot.lastUse = 0;
+	}
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+findFreeRange(std::uint16_t const length) const -> std::uint16_t
+{
+	/* Candidates for the start address are the beginning of the SRAM and the end of each slot */
+	std::uint16_t bestStart = sramSize;
+
+	for (std::size_t candidate = 0; candidate <= TMaxNumOfSlots; candidate++) {
+		std::uint16_t start = 0;
+		if (candidate < TMaxNumOfSlots) {
+			if (not reserved_[candidate]) {
+				continue;
+			}
+			start = slots_[candidate].startAddr + slots_[candidate].length;
+		}
+
+		if ((start + length > sramSize) || (start >= bestStart)) {
+			continue;
+		}
+
+		/* Check for overlaps with the other slots */
+		bool overlaps = false;
+		for (std::size_t i = 0; i < TMaxNumOfSlots; i++) {
+			if (reserved_[i] && (start < slots_[i].startAddr + slots_[i].length)
+					&& (slots_[i].startAddr < start + length)) {
+				overlaps = true;
+				break;
+			}
+		}
+
+		if (not overlaps) {
+			bestStart = start;
+		}
+	}
+
+	return bestStart;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+shrinkLeastRecentlyUsed(std::int8_t const protectedSlot) const -> bool
+{
+	std::int8_t oldest = invalidSlot;
+
+	for (std::size_t i = 0; i < TMaxNumOfSlots; i++) {
+		if (not reserved_[i] || not slots_[i].pattern.valid || (static_cast<std::int8_t>(i) == protectedSlot)
+				|| (slots_[i].length <= slots_[i].pattern.numOfSamples)) {
+			continue;
+		}
+		if ((oldest == invalidSlot) || (slots_[i].lastUse < slots_[oldest].lastUse)) {
+			oldest = static_cast<std::int8_t>(i);
+		}
+	}
+
+	if (oldest == invalidSlot) {
+		return false;
+	}
+
+	/* The first copy stays valid, it still plays without phase shift */
+	slots_[oldest].length = slots_[oldest].pattern.numOfSamples;
+
+	return true;
+}
+
+
+template <std::size_t TMaxNumOfSlots>
+auto SramSlotAllocator<TMaxNumOfSlots>::
+evictLeastRecentlyUsed(std::int8_t const protectedSlot) const -> bool
+{
+	std::int8_t oldest = invalidSlot;
+
+	for (std::size_t i = 0; i < TMaxNumOfSlots; i++) {
+		if (not reserved_[i] || (static_cast<std::int8_t>(i) == protectedSlot)) {
+			continue;
+		}
+		if ((oldest == invalidSlot) || (slots_[i].lastUse < slots_[oldest].lastUse)) {
+			oldest = static_cast<std::int8_t>(i);
+		}
+	}
+
+	if (oldest == invalidSlot) {
+		return false;
+	}
+
+	reserved_[oldest] = false;
+	slots_[oldest].pattern.valid = false;
+
+	return true;
+}
+
+
+} /* namespace SignalGeneration */
+
+#endif /* SRAMSLOTALLOCATOR_H_ */
@@ -24,6 +24,8 @@ Manager() :
 	coreClock_(Device::Core::systemCoreClock()),
 
 	hardwareTimer_(TIM2, coreClock_),
+	sweepTimerCh1_(TIM6, Device::InterruptId::Timer6Int, coreClock_),
+	sweepTimerCh2_(TIM7, Device::InterruptId::Timer7Int, coreClock_),
 	hardwareEncoder_(TIM3),
 
 	gpioA_(GPIOA),
@@ -66,11 +68,22 @@ Manager() :
 	supportVoltageGenerator_(spiSlaveDriver_[Dac], dacUpdatePin_),
 
 	directDigitalSynthesizerCh1_(spiSlaveDriver_[DDS1], ddsTriggerPin_),
-	signalGeneratorCh1_(SignalGeneration::Output::Ch1, directDigitalSynthesizerCh1_, frequencyController_, supportVoltageGenerator_),
+	frequencySweepCh1_(directDigitalSynthesizerCh1_, sweepTimerCh1_),
+	shiftKeyingCh1_(directDigitalSynthesizerCh1_, sweepTimerCh1_),
+	signalGeneratorCh1_(SignalGeneration::Output::Ch1, directDigitalSynthesizerCh1_, frequencyController_, supportVoltageGenerator_,
+			frequencySweepCh1_, shiftKeyingCh1_, timer_),
 
 	directDigitalSynthesizerCh2_(spiSlaveDriver_[DDS2], ddsTriggerPin_),
-	signalGeneratorCh2_(SignalGeneration::Output::Ch2, directDigitalSynthesizerCh2_, frequencyController_, supportVoltageGenerator_)
-{
+	frequencySweepCh2_(directDigitalSynthesizerCh2_, sweepTimerCh2_),
+	shiftKeyingCh2_(directDigitalSynthesizerCh2_, sweepTimerCh2_),
+	signalGeneratorCh2_(SignalGeneration::Output::Ch2, directDigitalSynthesizerCh2_, frequencyController_, supportVoltageGenerator_,
+			frequencySweepCh2_, shiftKeyingCh2_, timer_)
+{	/* Used to measure the duration of output changes */
+	Device::Core::enableCycleCounter();
+
+	/* Both synthesizers are triggered by ddsTriggerPin_ */
+	signalGeneratorCh1_.setTriggerSharedWith(signalGeneratorCh2_);
+	signalGeneratorCh2_.setTriggerSharedWith(signalGeneratorCh1_);
 }
 
 
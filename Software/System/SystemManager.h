@@ -12,6 +12,7 @@
 #include "HardwareCore.h"
 #include "HardwareGpio.h"
 #include "HardwareTimer.h"
+#include "HardwarePeriodicTimer.h"
 #include "HardwareI2C1.h"
 #include "HardwareSPI.h"
 #include "HardwareEncoder.h"
@@ -36,6 +37,8 @@
 #include "FrequencyController.h"
 #include "SupportVoltageGenerator.h"
 #include "DirectDigitalSynthesizer.h"
+#include "FrequencySweep.h"
+#include "ShiftKeying.h"
 #include "SignalGenerator.h"
 
 
@@ -65,6 +68,19 @@ enum SPI_Slave {
 };
 
 
+//------------------------------------------------------------
+//---------------------- SPI Bus Profiles --------------------
+/* Each slave runs at its own highest baud rate, the bus manager switches the settings with the slave.
+ * f_PCLK/2 = 40MHz is the limit of the SPI master, both the DDS and the DAC take more */
+constexpr Device::HardwareSPI::BusProfile ddsBusProfile = {
+		Device::HardwareSPI::Div2, Device::HardwareSPI::IdleHigh, Device::HardwareSPI::SecondEdge, 8};
+constexpr Device::HardwareSPI::BusProfile dacBusProfile = {
+		Device::HardwareSPI::Div2, Device::HardwareSPI::IdleHigh, Device::HardwareSPI::FirstEdge, 8};
+/* The display controller is slower: 10MHz */
+constexpr Device::HardwareSPI::BusProfile displayBusProfile = {
+		Device::HardwareSPI::Div8, Device::HardwareSPI::IdleHigh, Device::HardwareSPI::FirstEdge, 8};
+
+
 
 //------------------------------------------------------------
 //------------------------ Typedefs --------------------------
@@ -98,8 +114,10 @@ typedef Component::SystemHeartbeat<IoPin, Timer> Heartbeat;
 // Components SignalGeneration
 typedef SignalGeneration::FrequencyController<I2cSlaveDriver> FrequencyController;
 typedef SignalGeneration::SupportVoltageGenerator<SpiSlaveDriver, IoPin> SupportVoltageGenerator;
-typedef SignalGeneration::DirectDigitalSynthesizer<SpiSlaveDriver, IoPin> DirectDigitalSynthesizer;
-typedef SignalGeneration::SignalGenerator<DirectDigitalSynthesizer, FrequencyController, SupportVoltageGenerator> SignalGenerator;
+typedef SignalGeneration::DirectDigitalSynthesizer<SpiSlaveDriver, IoPin, Device::Core> DirectDigitalSynthesizer;
+typedef SignalGeneration::FrequencySweep<DirectDigitalSynthesizer, Device::HardwarePeriodicTimer, Device::Core> FrequencySweep;
+typedef SignalGeneration::ShiftKeying<DirectDigitalSynthesizer, Device::HardwarePeriodicTimer> ShiftKeying;
+typedef SignalGeneration::SignalGenerator<DirectDigitalSynthesizer, FrequencyController, SupportVoltageGenerator, FrequencySweep, ShiftKeying, Timer> SignalGenerator;
 
 
 class Manager
@@ -149,6 +167,8 @@ private:
 
 	/* Devices */
 	Device::HardwareTimer hardwareTimer_;
+	Device::HardwarePeriodicTimer sweepTimerCh1_;
+	Device::HardwarePeriodicTimer sweepTimerCh2_;
 	Device::HardwareEncoder hardwareEncoder_;
 
 	Device::HardwareGpio gpioA_;
@@ -183,11 +203,13 @@ private:
 	SpiMasterBusManager spi1Manager_;
 	SpiMasterBusManager spi2Manager_;
 
+	/* The DAC sets amplitude and offset of the outputs, so it is signal traffic like the DDS. SPI1 carries no bulk
+	 * traffic then and the display is alone on SPI2: The priority classes only take effect once both share a bus */
 	std::array<SpiSlaveDriver, SPI_Slave::SPI_count> spiSlaveDriver_ {
-		SpiSlaveDriver(spi1Manager_, gpioB_, Device::HardwareGpio::Pin::_0),	// DDS1
-		SpiSlaveDriver(spi1Manager_, gpioC_, Device::HardwareGpio::Pin::_4),	// DDS2
-		SpiSlaveDriver(spi2Manager_, gpioB_, Device::HardwareGpio::Pin::_12, gpioC_, Device::HardwareGpio::Pin::_6), // DSP
-		SpiSlaveDriver(spi1Manager_, gpioB_, Device::HardwareGpio::Pin::_10),	// Dac
+		SpiSlaveDriver(spi1Manager_, ddsBusProfile, SpiMasterBusManager::Priority::RealTime, gpioB_, Device::HardwareGpio::Pin::_0),	// DDS1
+		SpiSlaveDriver(spi1Manager_, ddsBusProfile, SpiMasterBusManager::Priority::RealTime, gpioC_, Device::HardwareGpio::Pin::_4),	// DDS2
+		SpiSlaveDriver(spi2Manager_, displayBusProfile, SpiMasterBusManager::Priority::Bulk, gpioB_, Device::HardwareGpio::Pin::_12, gpioC_, Device::HardwareGpio::Pin::_6), // DSP
+		SpiSlaveDriver(spi1Manager_, dacBusProfile, SpiMasterBusManager::Priority::RealTime, gpioB_, Device::HardwareGpio::Pin::_10),	// Dac
 	};
 
 	IoPin portExpander1IntPin_;
@@ -211,9 +233,13 @@ private:
 	SupportVoltageGenerator supportVoltageGenerator_;
 
 	DirectDigitalSynthesizer directDigitalSynthesizerCh1_;
+	FrequencySweep frequencySweepCh1_;
+	ShiftKeying shiftKeyingCh1_;
 	SignalGenerator signalGeneratorCh1_;
 
 	DirectDigitalSynthesizer directDigitalSynthesizerCh2_;
+	FrequencySweep frequencySweepCh2_;
+	ShiftKeying shiftKeyingCh2_;
 	SignalGenerator signalGeneratorCh2_;
 
 };
@@ -502,11 +502,12 @@ enterSubmenu(void) const
 	encoder_.addRotateLeftHandler( [this]() {
 		switch(currentForm_)
 		{
-			case SignalGeneration::Waveform::Sine: 		currentForm_ = SignalGeneration::Waveform::Saw_pos;  	break;
+			case SignalGeneration::Waveform::Sine: 		currentForm_ = SignalGeneration::Waveform::Arbitrary;  	break;
 			case SignalGeneration::Waveform::Rect: 		currentForm_ = SignalGeneration::Waveform::Sine;		break;
 			case SignalGeneration::Waveform::Triangle:	currentForm_ = SignalGeneration::Waveform::Rect; 		break;
 			case SignalGeneration::Waveform::Saw_neg:	currentForm_ = SignalGeneration::Waveform::Triangle; 	break;
 			case SignalGeneration::Waveform::Saw_pos: 	currentForm_ = SignalGeneration::Waveform::Saw_neg; 	break;
+			case SignalGeneration::Waveform::Arbitrary:	currentForm_ = SignalGeneration::Waveform::Saw_pos; 	break;
 			default: break;
 		}
 		printWaveform();
@@ -520,7 +521,8 @@ enterSubmenu(void) const
 			case SignalGeneration::Waveform::Rect: 		currentForm_ = SignalGeneration::Waveform::Triangle; 	break;
 			case SignalGeneration::Waveform::Triangle:	currentForm_ = SignalGeneration::Waveform::Saw_neg; 	break;
 			case SignalGeneration::Waveform::Saw_neg:	currentForm_ = SignalGeneration::Waveform::Saw_pos; 	break;
-			case SignalGeneration::Waveform::Saw_pos: 	currentForm_ = SignalGeneration::Waveform::Sine;		break;
+			case SignalGeneration::Waveform::Saw_pos: 	currentForm_ = SignalGeneration::Waveform::Arbitrary;	break;
+			case SignalGeneration::Waveform::Arbitrary:	currentForm_ = SignalGeneration::Waveform::Sine;		break;
 			default: break;
 		}
 		printWaveform();
@@ -588,6 +590,7 @@ reloadFormString(void) const
 		case SignalGeneration::Waveform::Triangle:	currentFormString_ = "Triangle"; 	break;
 		case SignalGeneration::Waveform::Saw_neg:	currentFormString_ = "Saw Falling"; break;
 		case SignalGeneration::Waveform::Saw_pos: 	currentFormString_ = "Saw Rising"; 	break;
+		case SignalGeneration::Waveform::Arbitrary:	currentFormString_ = "Arbitrary"; 	break;
 		default: break;
 	}
 }